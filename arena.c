@@ -0,0 +1,349 @@
+// Self-play arena.
+//
+//   ./connect4-arena [-g games] [-j threads] [-r plies] [-s seed] [-o FILE] CONFIG CONFIG...
+//
+// Plays a round robin between the configurations, `games` games per pairing
+// (default 100), on OpenMP threads. Each game starts from a random opening
+// of `plies` moves (default 4), and every opening is played twice with
+// colours swapped. A configuration is
+//
+//   random | medium | hard[:key=value,...]
+//
+// with hard keys depth, time (ms), nodes and eval (bitboard / windows),
+// e.g. hard:time=50 or hard:depth=8,eval=windows. Reports win/draw/loss and
+// the Elo difference with a 95% confidence interval per pairing, the score
+// of each configuration, and games/s. Random and medium players draw from
+// a per-game state derived from the seed, so a run with only those is
+// reproducible whatever the thread count; hard players with a time limit
+// still depend on timing. With -o every game is appended to
+// FILE as a game record (record.h), for connect4-replay.
+
+#define _POSIX_C_SOURCE 200112L
+#include "gamelogic.h"
+#include "bot.h"
+#include "tt.h"
+#include "record.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define ARENA_MAX_CONFIGS 8
+
+typedef enum { PLAYER_RANDOM, PLAYER_MEDIUM, PLAYER_HARD } PlayerKind;
+
+typedef struct {
+	const char* name;
+	PlayerKind  kind;
+	BotLimits   limits;
+} ArenaConfig;
+
+typedef struct {
+	int wins, draws, losses;   // from the first configuration's side
+} ArenaScore;
+
+static double now_sec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int parse_config(const char* spec, ArenaConfig* cfg) {
+	memset(cfg, 0, sizeof(*cfg));
+	cfg->name = spec;
+
+	if (strcmp(spec, "random") == 0) {
+		cfg->kind = PLAYER_RANDOM;
+		return 1;
+	}
+	if (strcmp(spec, "medium") == 0) {
+		cfg->kind = PLAYER_MEDIUM;
+		return 1;
+	}
+	if (strncmp(spec, "hard", 4) != 0 || (spec[4] != '\0' && spec[4] != ':'))
+		return 0;
+
+	cfg->kind = PLAYER_HARD;
+	const char* p = (spec[4] == ':') ? spec + 5 : spec + 4;
+	while (*p) {
+		char key[16], value[16];
+		int  len;
+		if (sscanf(p, "%15[a-z]=%15[a-z0-9]%n", key, value, &len) != 2)
+			return 0;
+
+		if (strcmp(key, "depth") == 0)      cfg->limits.max_depth = atoi(value);
+		else if (strcmp(key, "time") == 0)  cfg->limits.time_ms   = atoi(value);
+		else if (strcmp(key, "nodes") == 0) cfg->limits.max_nodes = strtoull(value, NULL, 10);
+		else if (strcmp(key, "eval") == 0 && strcmp(value, "bitboard") == 0)
+			cfg->limits.eval = BOT_EVAL_BITBOARD;
+		else if (strcmp(key, "eval") == 0 && strcmp(value, "windows") == 0)
+			cfg->limits.eval = BOT_EVAL_WINDOWS;
+		else
+			return 0;
+
+		p += len;
+		if (*p == ',') p++;
+		else if (*p)   return 0;
+	}
+	return 1;
+}
+
+// Random opening of `plies` moves in which nobody has won yet
+static void random_opening(char* out, int plies, unsigned* seed) {
+	for (;;) {
+		Board b;
+		initializeBoard(&b, 'A');
+		int n = 0, ok = 1;
+		while (n < plies) {
+			int c = (int)(rand_r(seed) % COLS);
+			if (game_drop(&b, c, b.current) == -1)
+				continue;
+			out[n++] = (char)('1' + c);
+			if (checkWin(&b, b.current)) {
+				ok = 0;
+				break;
+			}
+			b.current = (b.current == 'A') ? 'B' : 'A';
+		}
+		out[n] = '\0';
+		if (ok) return;
+	}
+}
+
+static int record_kind(const ArenaConfig* cfg) {
+	switch (cfg->kind) {
+	case PLAYER_RANDOM: return RECORD_RANDOM;
+	case PLAYER_MEDIUM: return RECORD_MEDIUM;
+	default:            return RECORD_HARD;
+	}
+}
+
+// Empty record of a game between a (A) and b (B), with the hard budgets
+static void record_start(GameRecord* r, const ArenaConfig* a, const ArenaConfig* b) {
+	record_init(r, 'A', record_kind(a) | record_kind(b) << 4);
+	for (int s = 0; s < 2; s++) {
+		const ArenaConfig* cfg = s ? b : a;
+		if (cfg->kind != PLAYER_HARD)
+			continue;
+		r->depth[s]   = (uint8_t)cfg->limits.max_depth;
+		r->eval[s]    = (uint8_t)cfg->limits.eval;
+		r->time_ms[s] = (uint16_t)cfg->limits.time_ms;
+	}
+}
+
+static int choose_move(const ArenaConfig* cfg, Board* b, unsigned* rng) {
+	switch (cfg->kind) {
+	case PLAYER_RANDOM:
+		return bot_choose_move_r(b, rng);
+	case PLAYER_MEDIUM:
+		return bot_choose_move_medium_r(b, rng);
+	default:
+		return pick_best_move(b, &cfg->limits, NULL);
+	}
+}
+
+// Plays one game from `opening`; A moves first. Returns 1 if A wins, -1 if
+// B wins, 0 for a draw. The moves and result go to rec unless it is NULL;
+// rng is the game's own random state.
+static int play_game(const ArenaConfig* a, const ArenaConfig* b, const char* opening,
+                     unsigned rng, GameRecord* rec) {
+	Board g;
+	initializeBoard(&g, 'A');
+	game_play_moves(&g, opening);
+	if (rec) {
+		record_start(rec, a, b);
+		for (const char* m = opening; *m; m++)
+			record_push(rec, *m - '1');
+	}
+
+	for (;;) {
+		char side = g.current;
+		int  col  = choose_move(side == 'A' ? a : b, &g, &rng);
+		if (col < 0 || game_drop(&g, col, side) == -1) {
+			// no legal move chosen: forfeit
+			if (rec) rec->result = (side == 'A' ? RECORD_WIN_B : RECORD_WIN_A) | RECORD_RESIGNED;
+			return (side == 'A') ? -1 : 1;
+		}
+		if (rec) record_push(rec, col);
+		if (checkWin(&g, side)) {
+			if (rec) rec->result = (side == 'A') ? RECORD_WIN_A : RECORD_WIN_B;
+			return (side == 'A') ? 1 : -1;
+		}
+		if (checkDraw(&g)) {
+			if (rec) rec->result = RECORD_DRAW;
+			return 0;
+		}
+		g.current = (side == 'A') ? 'B' : 'A';
+	}
+}
+
+static double elo(double score) {
+	if (score <= 0.0) return -INFINITY;
+	if (score >= 1.0) return INFINITY;
+	return -400.0 * log10(1.0 / score - 1.0);
+}
+
+// Score, Elo difference and its 95% interval from the per-game variance
+static void print_pairing(const ArenaConfig* a, const ArenaConfig* b, const ArenaScore* s) {
+	int    n     = s->wins + s->draws + s->losses;
+	double score = n ? (s->wins + 0.5 * s->draws) / n : 0.5;
+	double var   = n ? (s->wins * (1.0 - score) * (1.0 - score) +
+	                    s->draws * (0.5 - score) * (0.5 - score) +
+	                    s->losses * score * score) / n : 0.0;
+	double margin = n ? 1.96 * sqrt(var / n) : 0.0;
+
+	printf("%-24s vs %-24s +%-5d =%-5d -%-5d %6.1f%%  Elo %+7.1f [%+7.1f, %+7.1f]\n",
+		a->name, b->name, s->wins, s->draws, s->losses, 100.0 * score,
+		elo(score), elo(score - margin), elo(score + margin));
+}
+
+static void usage(const char* prog) {
+	fprintf(stderr, "usage: %s [-g games] [-j threads] [-r plies] [-s seed] [-o FILE] CONFIG CONFIG...\n", prog);
+	fprintf(stderr, "  CONFIG: random | medium | hard[:depth=N,time=MS,nodes=N,eval=bitboard|windows]\n");
+}
+
+int main(int argc, char** argv) {
+	int      games   = 100;
+	int      threads = 0;
+	int      plies   = 4;
+	unsigned seed    = 1;
+	const char* out_path = NULL;
+
+	ArenaConfig configs[ARENA_MAX_CONFIGS];
+	int n_configs = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+			games = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			plies = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			seed = (unsigned)strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			out_path = argv[++i];
+		} else if (n_configs < ARENA_MAX_CONFIGS && parse_config(argv[i], &configs[n_configs])) {
+			n_configs++;
+		} else {
+			fprintf(stderr, "arena: bad argument \"%s\"\n", argv[i]);
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if (n_configs < 2 || games < 1 || plies < 0 || plies > 20) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	// Openings are shared by every pairing; each one is played both ways.
+	// The games' random states come from the seed as given.
+	unsigned game_seed = seed;
+	int   n_openings = (games + 1) / 2;
+	char (*openings)[24] = malloc((size_t)n_openings * sizeof(*openings));
+	if (!openings) {
+		fprintf(stderr, "arena: out of memory\n");
+		return 1;
+	}
+	for (int i = 0; i < n_openings; i++)
+		random_opening(openings[i], plies, &seed);
+
+	int n_pairs = n_configs * (n_configs - 1) / 2;
+	int pair_a[ARENA_MAX_CONFIGS * ARENA_MAX_CONFIGS], pair_b[ARENA_MAX_CONFIGS * ARENA_MAX_CONFIGS];
+	for (int i = 0, p = 0; i < n_configs; i++) {
+		for (int j = i + 1; j < n_configs; j++, p++) {
+			pair_a[p] = i;
+			pair_b[p] = j;
+		}
+	}
+	ArenaScore scores[ARENA_MAX_CONFIGS * ARENA_MAX_CONFIGS];
+	memset(scores, 0, sizeof(scores));
+
+	FILE* out = NULL;
+	if (out_path && !(out = record_append(out_path))) {
+		fprintf(stderr, "arena: cannot append game records to %s\n", out_path);
+		free(openings);
+		return 1;
+	}
+
+	// Games run one per thread; the searches inside stay single-threaded
+	zobrist_init();
+	tt_open(NULL);
+	bot_set_threads(1);
+#ifdef _OPENMP
+	if (threads > 0)
+		omp_set_num_threads(threads);
+	threads = omp_get_max_threads();
+#else
+	threads = 1;
+#endif
+
+	printf("Arena: %d configurations, %d games per pairing, %d random plies, %d threads\n",
+		n_configs, 2 * n_openings, plies, threads);
+
+	int    n_jobs = n_pairs * 2 * n_openings;
+	double start  = now_sec();
+
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int job = 0; job < n_jobs; job++) {
+		int p       = job / (2 * n_openings);
+		int g       = job % (2 * n_openings);
+		int swapped = g & 1;
+		const ArenaConfig* a = &configs[pair_a[p]];
+		const ArenaConfig* b = &configs[pair_b[p]];
+
+		GameRecord rec;
+		GameRecord* recp = out ? &rec : NULL;
+		unsigned rng = game_seed ^ (unsigned)job * 2654435761u;
+		int r = swapped ? -play_game(b, a, openings[g / 2], rng, recp)
+		                :  play_game(a, b, openings[g / 2], rng, recp);
+
+#pragma omp critical(arena_score)
+		{
+			if (r > 0)       scores[p].wins++;
+			else if (r == 0) scores[p].draws++;
+			else             scores[p].losses++;
+			if (out) {
+				rec.finished = (uint32_t)time(NULL);
+				record_write(out, &rec);
+			}
+		}
+	}
+
+	double elapsed = now_sec() - start;
+
+	printf("\n");
+	for (int p = 0; p < n_pairs; p++)
+		print_pairing(&configs[pair_a[p]], &configs[pair_b[p]], &scores[p]);
+
+	printf("\n");
+	for (int i = 0; i < n_configs; i++) {
+		double points = 0.0;
+		int    played = 0;
+		for (int p = 0; p < n_pairs; p++) {
+			const ArenaScore* s = &scores[p];
+			int n = s->wins + s->draws + s->losses;
+			if (pair_a[p] == i)      points += s->wins + 0.5 * s->draws;
+			else if (pair_b[p] == i) points += s->losses + 0.5 * s->draws;
+			else                     continue;
+			played += n;
+		}
+		printf("%-24s %6.1f / %-6d %6.1f%%\n", configs[i].name, points, played,
+			played ? 100.0 * points / played : 0.0);
+	}
+
+	printf("\n%d games in %.1f s: %.1f games/s\n", n_jobs, elapsed,
+		elapsed > 0 ? n_jobs / elapsed : 0.0);
+
+	if (out && fclose(out) != 0)
+		fprintf(stderr, "arena: write error on %s\n", out_path);
+	free(openings);
+	tt_free();
+	return 0;
+}
@@ -0,0 +1,596 @@
+// Connect4 search benchmarks.
+//
+//   ./connect4-bench --scaling [depth]   Lazy SMP scaling report
+//   ./connect4-bench --tt-reuse [file]   TT hit rate, cold table vs. file
+//   ./connect4-bench --eval              leaf evaluation micro-benchmark
+//   ./connect4-bench --symmetry [depth]  TT hits with and without mirror keys
+//   ./connect4-bench --render [file]     board frames/s and bytes per frame
+//   ./connect4-bench --suite [--baseline file] [--threshold pct]
+//                                        standard suite, JSON on stdout
+//
+// Positions are written as 1-based column sequences, the same digits a
+// player types during a game.
+
+#define _POSIX_C_SOURCE 200112L
+#include "gamelogic.h"
+#include "bot.h"
+#include "tt.h"
+#include "ui.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Mid-game positions, past the opening book
+static const char* scaling_positions[] = {
+	"4455443",
+	"32164625",
+	"4343422",
+	"44444123",
+	"3344255",
+	"76543211",
+};
+
+#define SCALING_POSITIONS (int)(sizeof scaling_positions / sizeof scaling_positions[0])
+
+static const int scaling_threads[] = { 1, 2, 4, 8, 16, 32 };
+
+#define SCALING_STEPS (int)(sizeof scaling_threads / sizeof scaling_threads[0])
+
+static double now_sec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int load_position(Board* b, const char* moves) {
+	initializeBoard(b, 'A');
+	if (game_play_moves(b, moves) < 0 || checkWin(b, 'A') || checkWin(b, 'B')) {
+		fprintf(stderr, "bench: invalid position \"%s\"\n", moves);
+		return 0;
+	}
+	return 1;
+}
+
+// Time-to-depth and nodes/s of pick_best_move for 1..32 threads, each
+// run starting from an empty TT so the thread counts are comparable.
+static int run_scaling(int depth) {
+	double base_time = 0.0;
+
+	BotLimits limits = { .max_depth = depth };
+	printf("Lazy SMP scaling, depth %d, %d positions\n", depth, SCALING_POSITIONS);
+	printf("%8s %14s %12s %12s %9s\n", "threads", "nodes", "time (ms)", "knodes/s", "speedup");
+
+	for (int s = 0; s < SCALING_STEPS; s++) {
+		unsigned long long total_nodes = 0;
+		double total_time = 0.0;
+
+		bot_set_threads(scaling_threads[s]);
+		for (int i = 0; i < SCALING_POSITIONS; i++) {
+			Board b;
+			if (!load_position(&b, scaling_positions[i]))
+				return 1;
+
+			tt_clear();
+			BotStats st;
+			double t0 = now_sec();
+			pick_best_move(&b, &limits, &st);
+			total_time += now_sec() - t0;
+			total_nodes += st.nodes;
+		}
+
+		if (s == 0)
+			base_time = total_time;
+		printf("%8d %14llu %12.1f %12.0f %8.2fx\n",
+			scaling_threads[s], total_nodes, total_time * 1e3,
+			total_time > 0 ? total_nodes / total_time / 1e3 : 0.0,
+			total_time > 0 ? base_time / total_time : 0.0);
+		fflush(stdout);
+	}
+	return 0;
+}
+
+// Searches the scaling corpus once and returns the TT hit rate in percent
+static double corpus_hit_rate(int depth) {
+	unsigned long long total_nodes = 0, total_hits = 0;
+
+	BotLimits limits = { .max_depth = depth };
+	for (int i = 0; i < SCALING_POSITIONS; i++) {
+		Board b;
+		if (!load_position(&b, scaling_positions[i]))
+			return 0.0;
+		BotStats st;
+		pick_best_move(&b, &limits, &st);
+		total_nodes += st.nodes;
+		total_hits  += st.tt_hits;
+	}
+	return total_nodes ? 100.0 * total_hits / total_nodes : 0.0;
+}
+
+// Persisted entries are only useful if keys are stable across runs: search
+// the corpus with an empty private table, then with the table in `path`.
+// Run it twice; from the second run on the file-backed table is warm.
+static int run_tt_reuse(const char* path, int depth) {
+	tt_free();
+	tt_open(NULL);
+	double cold = corpus_hit_rate(depth);
+	tt_free();
+
+	if (!tt_open(path)) {
+		fprintf(stderr, "bench: cannot map %s\n", path);
+		return 1;
+	}
+	double warm = corpus_hit_rate(depth);
+	tt_free();
+
+	printf("TT reuse, depth %d, %d positions\n", depth, SCALING_POSITIONS);
+	printf("  cold (empty table): %5.1f%% hits\n", cold);
+	printf("  warm (%s): %5.1f%% hits\n", path, warm);
+	return 0;
+}
+
+// Opening lines, several of them mirror images of each other, where
+// reflected transpositions are most common
+static const char* symmetry_positions[] = {
+	"43",
+	"45",
+	"4433",
+	"4455",
+	"3",
+	"5",
+	"434",
+	"454",
+};
+
+#define SYMMETRY_POSITIONS (int)(sizeof symmetry_positions / sizeof symmetry_positions[0])
+
+// Searches the opening and mid-game corpora in one table, once with plain
+// keys and once with mirror-canonical keys, starting from an empty table
+// each time
+static int run_symmetry(int depth) {
+	BotLimits limits = { .max_depth = depth };
+	printf("Mirror symmetry, depth %d, %d positions\n", depth,
+		SYMMETRY_POSITIONS + SCALING_POSITIONS);
+	printf("%10s %14s %14s %8s %12s\n", "keys", "nodes", "tt hits", "hits", "time (ms)");
+
+	for (int on = 0; on <= 1; on++) {
+		unsigned long long total_nodes = 0, total_hits = 0;
+		double total_time = 0.0;
+
+		bot_set_symmetry(on);
+		tt_clear();
+		for (int i = 0; i < SYMMETRY_POSITIONS + SCALING_POSITIONS; i++) {
+			const char* moves = (i < SYMMETRY_POSITIONS)
+				? symmetry_positions[i] : scaling_positions[i - SYMMETRY_POSITIONS];
+			Board b;
+			if (!load_position(&b, moves))
+				return 1;
+
+			BotStats st;
+			double t0 = now_sec();
+			pick_best_move(&b, &limits, &st);
+			total_time += now_sec() - t0;
+			total_nodes += st.nodes;
+			total_hits  += st.tt_hits;
+		}
+		printf("%10s %14llu %14llu %7.1f%% %12.1f\n", on ? "canonical" : "plain",
+			total_nodes, total_hits,
+			total_nodes ? 100.0 * total_hits / total_nodes : 0.0, total_time * 1e3);
+		fflush(stdout);
+	}
+	bot_set_symmetry(1);
+	return 0;
+}
+
+#define EVAL_POSITIONS 4096
+#define EVAL_ROUNDS    200
+
+// Average cost of one evaluate call per variant over random mid-game
+// positions (no side has four yet, as at a real search leaf)
+static int run_eval(void) {
+	static Board positions[EVAL_POSITIONS];
+	static const char* names[] = { "bitboard", "windows" };
+	static const int variants[] = { BOT_EVAL_BITBOARD, BOT_EVAL_WINDOWS };
+	unsigned seed = 12345;
+
+	for (int i = 0; i < EVAL_POSITIONS; ) {
+		Board* b = &positions[i];
+		initializeBoard(b, 'A');
+		int plies = 8 + (int)(rand_r(&seed) % 24);
+		for (int k = 0; k < plies; k++) {
+			if (game_drop(b, (int)(rand_r(&seed) % COLS), b->current) != -1)
+				b->current = (b->current == 'A') ? 'B' : 'A';
+		}
+		if (!checkWin(b, 'A') && !checkWin(b, 'B'))
+			i++;
+	}
+
+	double ns[2];
+	for (int v = 0; v < 2; v++) {
+		volatile int sink = 0;
+		double t0 = now_sec();
+		for (int round = 0; round < EVAL_ROUNDS; round++) {
+			for (int i = 0; i < EVAL_POSITIONS; i++)
+				sink += bot_evaluate(&positions[i], positions[i].current, variants[v]);
+		}
+		ns[v] = (now_sec() - t0) * 1e9 / ((double)EVAL_ROUNDS * EVAL_POSITIONS);
+		(void)sink;
+	}
+
+	printf("Leaf evaluation, %d positions x %d rounds\n", EVAL_POSITIONS, EVAL_ROUNDS);
+	for (int v = 0; v < 2; v++)
+		printf("  %-9s %8.1f ns/eval\n", names[v], ns[v]);
+	printf("  speedup   %8.1fx\n", ns[0] > 0 ? ns[1] / ns[0] : 0.0);
+	return 0;
+}
+
+#define RENDER_GAMES 2000
+
+// Terminal output of random games, written to path (default /dev/null):
+// each position as a full board, then the drop animated. The animation is
+// compared with a clear and a full board per step (and one after it lands),
+// which is what it sent before frames were diffed.
+static int run_render(const char* path) {
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		perror(path);
+		return 1;
+	}
+	ui_set_output(fd);
+
+	UiOptions          opt  = { .use_color = 1, .delay_ms = 0 };
+	unsigned           seed = 12345;
+	unsigned long long moves = 0, redraw_bytes = 0;
+	unsigned long long board_frames = 0, board_bytes = 0, anim_frames = 0, anim_bytes = 0;
+	double             t_board = 0.0, t_anim = 0.0;
+
+	for (int game = 0; game < RENDER_GAMES; game++) {
+		Board b;
+		initializeBoard(&b, 'A');
+		while (!checkDraw(&b)) {
+			int col = (int)(rand_r(&seed) % COLS);
+			int row = game_can_drop(&b, col);
+			if (row == -1)
+				continue;
+
+			unsigned long long f0, b0, f1, b1, f2, b2;
+			ui_frame_stats(&f0, &b0);
+			double t0 = now_sec();
+			ui_print_board(&b, 1);
+			double t1 = now_sec();
+			ui_frame_stats(&f1, &b1);
+			ui_drop_with_animation(&b, col, b.current, &opt);
+			double t2 = now_sec();
+			ui_frame_stats(&f2, &b2);
+
+			board_frames += f1 - f0;
+			board_bytes  += b1 - b0;
+			anim_frames  += f2 - f1;
+			anim_bytes   += b2 - b1;
+			t_board      += t1 - t0;
+			t_anim       += t2 - t1;
+			// "\033[H\033[J" and the board, the falling piece colored
+			redraw_bytes += (unsigned long long)(row + 2) * (6 + (b1 - b0) + 9);
+			moves++;
+
+			if (checkWin(&b, b.current))
+				break;
+			b.current = (b.current == 'A') ? 'B' : 'A';
+		}
+	}
+	close(fd);
+
+	printf("Rendering, %d random games, %llu moves, one write per frame\n", RENDER_GAMES, moves);
+	printf("  board      %10.0f frames/s %7.1f bytes/frame\n",
+		t_board > 0 ? board_frames / t_board : 0.0, (double)board_bytes / board_frames);
+	printf("  animation  %10.0f frames/s %7.1f bytes/frame %7.1f bytes/move\n",
+		t_anim > 0 ? anim_frames / t_anim : 0.0, (double)anim_bytes / anim_frames,
+		(double)anim_bytes / moves);
+	printf("  redrawn    %10s          %7.1f bytes/frame %7.1f bytes/move\n", "",
+		(double)redraw_bytes / (anim_frames + moves), (double)redraw_bytes / moves);
+	return 0;
+}
+
+// Standard suite. Groups are phase x difficulty; difficulty is the solver's
+// node count from an empty table (easy < 1k, medium < 100k, hard above).
+// Scores come from the strong solver.
+typedef struct {
+	const char* phase;
+	const char* level;
+	const char* moves;
+	int         score;
+} SuitePosition;
+
+static const SuitePosition suite_positions[] = {
+	{ "opening", "easy",   "231715746757",                    10 },
+	{ "opening", "easy",   "4661733275",                       9 },
+	{ "opening", "easy",   "321565476524",                    -4 },
+	{ "opening", "easy",   "234655115156",                     2 },
+	{ "opening", "easy",   "464525624",                       -5 },
+	{ "opening", "medium", "73151557",                        -5 },
+	{ "opening", "medium", "211433542",                        5 },
+	{ "opening", "medium", "13365143454",                     -2 },
+	{ "opening", "medium", "634375565",                       -3 },
+	{ "opening", "medium", "22435674",                        -5 },
+	{ "opening", "hard",   "676213533",                        3 },
+	{ "opening", "hard",   "31732411352",                      2 },
+	{ "opening", "hard",   "211172617",                        3 },
+	{ "opening", "hard",   "14244113",                         2 },
+	{ "opening", "hard",   "135114652771",                     0 },
+
+	{ "middle",  "easy",   "244221655142443",                -10 },
+	{ "middle",  "easy",   "54451346526517",                  12 },
+	{ "middle",  "easy",   "5624752362557235",                 9 },
+	{ "middle",  "easy",   "436731615366737145",               2 },
+	{ "middle",  "easy",   "232431744655732255362",            3 },
+	{ "middle",  "medium", "74152727636772332",                2 },
+	{ "middle",  "medium", "256776675521747613",              -2 },
+	{ "middle",  "medium", "7452415575173166",                -2 },
+	{ "middle",  "medium", "27675373432522356",                4 },
+	{ "middle",  "medium", "7331164366556574",                 1 },
+	{ "middle",  "hard",   "476221661175665447377",            0 },
+	{ "middle",  "hard",   "1112233311334231",                 1 },
+	{ "middle",  "hard",   "65365251447755226",                1 },
+	{ "middle",  "hard",   "144657211577316",                  3 },
+	{ "middle",  "hard",   "23643245313334",                   1 },
+
+	{ "endgame", "easy",   "131455622532542111455343613427",  -3 },
+	{ "endgame", "easy",   "5372464157237624322665",           6 },
+	{ "endgame", "easy",   "26336324435767375671757",          6 },
+	{ "endgame", "easy",   "1131546613764775115635653623",     2 },
+	{ "endgame", "easy",   "71471537231122425377337421555",   -3 },
+	{ "endgame", "medium", "35465173662557756637531217263",   -2 },
+	{ "endgame", "medium", "714571531556775453317471",         2 },
+	{ "endgame", "medium", "5617212543572223567665421",       -3 },
+	{ "endgame", "medium", "4762467644442522371613",           3 },
+	{ "endgame", "medium", "65332433311276444434151177",      -3 },
+	{ "endgame", "hard",   "1716576772776245632645",           5 },
+	{ "endgame", "hard",   "165325572272227663774144343",      0 },
+	{ "endgame", "hard",   "43353442147651475471663",         -2 },
+	{ "endgame", "hard",   "5712654316737711225655",          -2 },
+	{ "endgame", "hard",   "6261773435422533337411",           0 },
+};
+
+#define SUITE_POSITIONS (int)(sizeof suite_positions / sizeof suite_positions[0])
+#define SUITE_DEPTH     12
+#define SUITE_REPEAT    3    // searches are short: keep the fastest of 3 runs
+
+typedef struct {
+	double             us[SUITE_POSITIONS];
+	int                n;
+	unsigned long long nodes;
+	unsigned long long hits;
+	int                correct;
+} SuiteStats;
+
+static void suite_add(SuiteStats* s, double us, unsigned long long nodes,
+                      unsigned long long hits, int correct) {
+	s->us[s->n++] = us;
+	s->nodes     += nodes;
+	s->hits      += hits;
+	s->correct   += correct;
+}
+
+static int cmp_double(const void* a, const void* b) {
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of a sorted sample
+static double percentile(const double* sorted, int n, int p) {
+	int rank = (p * n + 99) / 100;
+	return sorted[(rank < 1 ? 1 : rank) - 1];
+}
+
+static double suite_mean_us(const SuiteStats* s) {
+	double sum = 0.0;
+	for (int i = 0; i < s->n; i++)
+		sum += s->us[i];
+	return s->n ? sum / s->n : 0.0;
+}
+
+static void suite_print(const char* name, SuiteStats* s) {
+	double sum = 0.0;
+	for (int i = 0; i < s->n; i++)
+		sum += s->us[i];
+	qsort(s->us, s->n, sizeof(double), cmp_double);
+	printf("\"%s\": {\"mean_us\": %.1f, \"p50_us\": %.1f, \"p90_us\": %.1f, \"max_us\": %.1f, "
+		"\"nodes\": %llu, \"knodes_per_s\": %.1f, \"tt_hit_pct\": %.2f, \"correct\": %d}",
+		name, s->n ? sum / s->n : 0.0, percentile(s->us, s->n, 50), percentile(s->us, s->n, 90),
+		s->us[s->n - 1], s->nodes, sum > 0 ? s->nodes / sum * 1e3 : 0.0,
+		s->nodes ? 100.0 * s->hits / s->nodes : 0.0, s->correct);
+}
+
+// Outcome (-1, 0, 1) for the side to move of playing col in b
+static int move_outcome(const Board* b, int col) {
+	Board child = *b;
+	char  side  = child.current;
+	if (game_drop(&child, col, side) == -1)
+		return -2;
+	if (checkWin(&child, side))
+		return 1;
+	child.current = (side == 'A') ? 'B' : 'A';
+	tt_clear();
+	return -solve_position(&child, SOLVE_WEAK, NULL);
+}
+
+// Mean times per group from a previous --suite output. The output puts one
+// group per line, so the baseline is read back line by line.
+typedef struct {
+	char   phase[16];
+	char   level[16];
+	double search_us;
+	double solve_us;
+	int    search_correct;
+	int    solve_correct;
+} SuiteBaseline;
+
+static int read_baseline(const char* path, SuiteBaseline* out, int max) {
+	FILE* f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	char line[1024];
+	int n = 0;
+	while (n < max && fgets(line, sizeof line, f)) {
+		SuiteBaseline* b = &out[n];
+		const char* search = strstr(line, "\"search\": {");
+		const char* solve  = strstr(line, "\"solve\": {");
+		if (sscanf(line, " {\"phase\": \"%15[^\"]\", \"level\": \"%15[^\"]\"", b->phase, b->level) != 2 ||
+		    !search || !solve ||
+		    sscanf(search, "\"search\": {\"mean_us\": %lf", &b->search_us) != 1 ||
+		    sscanf(solve, "\"solve\": {\"mean_us\": %lf", &b->solve_us) != 1 ||
+		    !strstr(search, "\"correct\": ") || !strstr(solve, "\"correct\": "))
+			continue;
+		b->search_correct = atoi(strstr(search, "\"correct\": ") + 11);
+		b->solve_correct  = atoi(strstr(solve, "\"correct\": ") + 11);
+		n++;
+	}
+	fclose(f);
+	return n;
+}
+
+// Runs every suite position through the hard-bot search (fixed depth, one
+// thread, empty table, best of SUITE_REPEAT) and the strong solver, and prints one JSON object.
+// With a baseline, groups slower than baseline * (1 + threshold%) or with
+// fewer correct answers are reported on stderr and the exit status is 1.
+static int run_suite(const char* baseline_path, double threshold) {
+	static SuiteBaseline baseline[64];
+	int n_baseline = 0;
+	if (baseline_path && (n_baseline = read_baseline(baseline_path, baseline, 64)) < 0)
+		return 1;
+
+	BotLimits limits = { .max_depth = SUITE_DEPTH };
+	bot_set_threads(1);
+
+	SuiteStats total_search = { 0 }, total_solve = { 0 };
+	int regressions = 0;
+
+	printf("{\"suite\": \"connect4\", \"depth\": %d, \"threads\": 1, \"positions\": %d, \"groups\": [\n",
+		SUITE_DEPTH, SUITE_POSITIONS);
+
+	for (int start = 0; start < SUITE_POSITIONS; ) {
+		const SuitePosition* g = &suite_positions[start];
+		int end = start;
+		while (end < SUITE_POSITIONS &&
+		       strcmp(suite_positions[end].phase, g->phase) == 0 &&
+		       strcmp(suite_positions[end].level, g->level) == 0)
+			end++;
+
+		SuiteStats search = { 0 }, solve = { 0 };
+		for (int i = start; i < end; i++) {
+			const SuitePosition* p = &suite_positions[i];
+			Board b;
+			if (!load_position(&b, p->moves))
+				return 1;
+			int outcome = (p->score > 0) - (p->score < 0);
+
+			int move = -1;
+			double us = 0.0;
+			BotStats st;
+			for (int k = 0; k < SUITE_REPEAT; k++) {
+				tt_clear();
+				move = pick_best_move(&b, &limits, &st);
+				if (k == 0 || st.elapsed_ns / 1e3 < us)
+					us = st.elapsed_ns / 1e3;
+			}
+			int ok = (move_outcome(&b, move) == outcome);
+			suite_add(&search, us, st.nodes, st.tt_hits, ok);
+			suite_add(&total_search, us, st.nodes, st.tt_hits, ok);
+
+			tt_clear();
+			SolveResult r;
+			solve_position(&b, SOLVE_STRONG, &r);
+			ok = (r.score == p->score);
+			us = r.stats.elapsed_ns / 1e3;
+			suite_add(&solve, us, r.stats.nodes, r.stats.tt_hits, ok);
+			suite_add(&total_solve, us, r.stats.nodes, r.stats.tt_hits, ok);
+		}
+
+		for (int k = 0; k < n_baseline; k++) {
+			const SuiteBaseline* base = &baseline[k];
+			if (strcmp(base->phase, g->phase) != 0 || strcmp(base->level, g->level) != 0)
+				continue;
+			double search_us = suite_mean_us(&search), solve_us = suite_mean_us(&solve);
+			if (search_us > base->search_us * (1.0 + threshold / 100.0) ||
+			    solve_us > base->solve_us * (1.0 + threshold / 100.0) ||
+			    search.correct < base->search_correct || solve.correct < base->solve_correct) {
+				fprintf(stderr, "REGRESSION %s/%s: search %.1f us (was %.1f), solve %.1f us (was %.1f), "
+					"correct %d/%d (was %d/%d)\n", g->phase, g->level,
+					search_us, base->search_us, solve_us, base->solve_us,
+					search.correct, solve.correct, base->search_correct, base->solve_correct);
+				regressions++;
+			}
+		}
+
+		printf("  {\"phase\": \"%s\", \"level\": \"%s\", \"positions\": %d, ", g->phase, g->level, end - start);
+		suite_print("search", &search);
+		printf(", ");
+		suite_print("solve", &solve);
+		printf("}%s\n", end < SUITE_POSITIONS ? "," : "");
+		fflush(stdout);
+		start = end;
+	}
+
+	printf("], \"total\": {");
+	suite_print("search", &total_search);
+	printf(", ");
+	suite_print("solve", &total_solve);
+	printf("}}\n");
+
+	if (baseline_path)
+		fprintf(stderr, "%d regression(s) against %s (threshold %.0f%%)\n",
+			regressions, baseline_path, threshold);
+	return regressions ? 1 : 0;
+}
+
+static void usage(const char* prog) {
+	fprintf(stderr, "usage: %s --scaling [depth]\n", prog);
+	fprintf(stderr, "       %s --tt-reuse [file]\n", prog);
+	fprintf(stderr, "       %s --eval\n", prog);
+	fprintf(stderr, "       %s --symmetry [depth]\n", prog);
+	fprintf(stderr, "       %s --render [file]\n", prog);
+	fprintf(stderr, "       %s --suite [--baseline file] [--threshold pct]\n", prog);
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	// Private table: benchmarks must not read or dirty the shared tt.bin
+	zobrist_init();
+	tt_open(NULL);
+
+	int rc = 2;
+	if (strcmp(argv[1], "--scaling") == 0) {
+		int depth = (argc > 2) ? atoi(argv[2]) : 12;
+		rc = run_scaling(depth);
+	} else if (strcmp(argv[1], "--tt-reuse") == 0) {
+		rc = run_tt_reuse((argc > 2) ? argv[2] : TT_FILE, 12);
+	} else if (strcmp(argv[1], "--eval") == 0) {
+		rc = run_eval();
+	} else if (strcmp(argv[1], "--symmetry") == 0) {
+		int depth = (argc > 2) ? atoi(argv[2]) : 12;
+		rc = run_symmetry(depth);
+	} else if (strcmp(argv[1], "--render") == 0) {
+		rc = run_render((argc > 2) ? argv[2] : "/dev/null");
+	} else if (strcmp(argv[1], "--suite") == 0) {
+		const char* baseline  = NULL;
+		double      threshold = 20.0;
+		for (int i = 2; i + 1 < argc; i += 2) {
+			if (strcmp(argv[i], "--baseline") == 0)       baseline  = argv[i + 1];
+			else if (strcmp(argv[i], "--threshold") == 0) threshold = atof(argv[i + 1]);
+		}
+		rc = run_suite(baseline, threshold);
+	} else {
+		usage(argv[0]);
+	}
+
+	return rc;
+}
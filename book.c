@@ -0,0 +1,104 @@
+#include "book.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(BookHeader) == 32, "book header layout");
+
+static void*           book_map     = NULL;
+static size_t          book_bytes   = 0;
+static const uint64_t* book_entries = NULL;
+static uint64_t        book_count   = 0;
+
+// 7-bit field of column c: stones of `me` from the bottom up, then a
+// marker above the top stone. The board stores row 0 at the top.
+static uint64_t column_field(uint64_t me, uint64_t mask, int c) {
+	uint64_t col    = (mask >> (c * 7)) & 0x3F;
+	uint64_t stones = (me >> (c * 7)) & 0x3F;
+	int      height = __builtin_popcountll(col);
+
+	uint64_t field = 1ULL << height;
+	for (int h = 0; h < height; h++) {
+		if (stones & (1ULL << (ROWS - 1 - h)))
+			field |= 1ULL << h;
+	}
+	return field;
+}
+
+uint64_t book_key(const Board* b, int* flip) {
+	uint64_t me  = (b->current == 'A') ? b->playerA : b->playerB;
+	uint64_t key = 0, mirror = 0;
+	for (int c = 0; c < COLS; c++) {
+		uint64_t f = column_field(me, b->mask, c);
+		key    |= f << (c * 7);
+		mirror |= f << ((COLS - 1 - c) * 7);
+	}
+	*flip = mirror < key;
+	return *flip ? mirror : key;
+}
+
+int book_open(const char* path) {
+	if (book_map) return 1;
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+
+	void* map = MAP_FAILED;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(BookHeader))
+		map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return 0;
+
+	const BookHeader* h = (const BookHeader*)map;
+	if (memcmp(h->magic, BOOK_FILE_MAGIC, 4) != 0 || h->version != BOOK_FILE_VERSION ||
+	    h->entry_bytes != sizeof(uint64_t) ||
+	    (size_t)st.st_size != sizeof(BookHeader) + h->count * sizeof(uint64_t)) {
+		munmap(map, (size_t)st.st_size);
+		return 0;
+	}
+
+	book_map     = map;
+	book_bytes   = (size_t)st.st_size;
+	book_entries = (const uint64_t*)((const char*)map + sizeof(BookHeader));
+	book_count   = h->count;
+	return 1;
+}
+
+// The book is optional: without book.bin the bot searches from move one
+void book_init() {
+	book_open(BOOK_FILE);
+}
+
+void book_close() {
+	if (!book_map) return;
+	munmap(book_map, book_bytes);
+	book_map     = NULL;
+	book_entries = NULL;
+	book_count   = 0;
+}
+
+int book_lookup(const Board* b, int* score) {
+	if (!book_count) return -1;
+
+	int flip;
+	uint64_t key = book_key(b, &flip);
+
+	uint64_t lo = 0, hi = book_count;
+	while (lo < hi) {
+		uint64_t mid = lo + (hi - lo) / 2;
+		if (book_entry_key(book_entries[mid]) < key) lo = mid + 1;
+		else                                         hi = mid;
+	}
+	if (lo == book_count || book_entry_key(book_entries[lo]) != key)
+		return -1;
+
+	uint64_t e = book_entries[lo];
+	if (score) *score = book_entry_score(e);
+	return flip ? COLS - 1 - book_entry_move(e) : book_entry_move(e);
+}
@@ -0,0 +1,57 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#pragma once
+
+#include <stdint.h>
+
+#include "gamelogic.h"
+
+/* Solver-generated opening book.
+ *
+ * book.bin holds one 64-bit entry per position with fewer than `plies`
+ * stones, written by connect4-bookgen. Mirror images share an entry: the
+ * key is the smaller of the position's and its reflection's. Entries are
+ * sorted, so the bot maps the file read-only and binary-searches it.
+ *
+ * entry layout: key:49 | score+32:6 | move:3
+ *
+ * The key gives each column 7 bits, counted from the bottom: a bit per
+ * stone of the side to move and a marker bit on top of the column, so it
+ * is unique per position. score is the solver score of the side to move,
+ * move the 0-based column reaching it (in the key's orientation).
+ */
+
+#define BOOK_FILE         "book.bin"
+#define BOOK_FILE_MAGIC   "C4BK"
+#define BOOK_FILE_VERSION 1
+
+typedef struct {
+	char     magic[4];
+	uint32_t version;
+	uint32_t plies;          /* positions with fewer stones are covered */
+	uint32_t entry_bytes;
+	uint64_t count;
+	uint8_t  reserved[8];
+} BookHeader;
+
+/* Canonical key of b; *flip is set when it is the mirror image's key. */
+uint64_t book_key(const Board* b, int* flip);
+
+static inline uint64_t book_entry(uint64_t key, int score, int move) {
+	return key << 9 | (uint64_t)(score + 32) << 3 | (uint64_t)move;
+}
+
+static inline uint64_t book_entry_key(uint64_t e) { return e >> 9; }
+static inline int book_entry_score(uint64_t e)    { return (int)((e >> 3) & 63) - 32; }
+static inline int book_entry_move(uint64_t e)     { return (int)(e & 7); }
+
+void book_init();
+int  book_open(const char* path);   /* 1 if a valid book was mapped */
+void book_close();
+
+/* Book move (0-based column) for b, or -1 if b is not in the book.
+ * score, if given, receives the solver score of the side to move. */
+int book_lookup(const Board* b, int* score);
+
+#endif
@@ -0,0 +1,193 @@
+// Opening book generator.
+//
+//   ./connect4-bookgen [plies] [file] [prefix]
+//
+// Strongly solves every position with fewer than `plies` stones (default
+// BOOK_PLIES) that can be reached from the 1-based move string `prefix`
+// (default: the empty board), keeping one of each mirror pair, and writes
+// the sorted entries to `file` (default book.bin). Solving is spread over
+// OpenMP threads.
+
+#include "gamelogic.h"
+#include "bot.h"
+#include "book.h"
+#include "tt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BOOK_PLIES 10
+
+typedef struct {
+	uint64_t key;
+	Board    board;   // oriented so that book_key needs no flip
+	int      ply;
+} BookPos;
+
+static BookPos* positions    = NULL;
+static size_t   n_positions  = 0;
+static size_t   cap_positions = 0;
+
+// Canonical keys already visited; open addressing, 0 = empty slot
+static uint64_t* seen      = NULL;
+static size_t    seen_cap  = 0;
+static size_t    seen_used = 0;
+
+static void die(const char* msg) {
+	fprintf(stderr, "bookgen: %s\n", msg);
+	exit(1);
+}
+
+static size_t seen_slot(const uint64_t* table, size_t cap, uint64_t key) {
+	size_t i = (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 20) & (cap - 1);
+	while (table[i] && table[i] != key)
+		i = (i + 1) & (cap - 1);
+	return i;
+}
+
+// Returns 1 if key was new
+static int seen_insert(uint64_t key) {
+	if (2 * (seen_used + 1) > seen_cap) {
+		size_t    cap   = seen_cap ? 2 * seen_cap : 1 << 16;
+		uint64_t* table = calloc(cap, sizeof(uint64_t));
+		if (!table) die("out of memory");
+		for (size_t i = 0; i < seen_cap; i++) {
+			if (seen[i])
+				table[seen_slot(table, cap, seen[i])] = seen[i];
+		}
+		free(seen);
+		seen     = table;
+		seen_cap = cap;
+	}
+
+	size_t i = seen_slot(seen, seen_cap, key);
+	if (seen[i]) return 0;
+	seen[i] = key;
+	seen_used++;
+	return 1;
+}
+
+static void mirror_board(Board* b) {
+	uint64_t a = 0, bb = 0;
+	for (int c = 0; c < COLS; c++) {
+		int shift = (COLS - 1 - 2 * c) * 7;
+		uint64_t col = 0x7FULL << (c * 7);
+		a  |= shift >= 0 ? (b->playerA & col) << shift : (b->playerA & col) >> -shift;
+		bb |= shift >= 0 ? (b->playerB & col) << shift : (b->playerB & col) >> -shift;
+	}
+	b->playerA = a;
+	b->playerB = bb;
+	b->mask    = a | bb;
+}
+
+// Collects every undecided position below `plies` stones, one per mirror
+// pair. Only canonical positions are expanded: the children of a mirror
+// image are the mirror images of its children.
+static void collect(const Board* b, int ply, int plies) {
+	if (ply >= plies || checkWin(b, 'A') || checkWin(b, 'B') || checkDraw(b))
+		return;
+
+	int flip;
+	uint64_t key = book_key(b, &flip);
+	if (!seen_insert(key))
+		return;
+
+	if (n_positions == cap_positions) {
+		cap_positions = cap_positions ? 2 * cap_positions : 1024;
+		positions = realloc(positions, cap_positions * sizeof(BookPos));
+		if (!positions) die("out of memory");
+	}
+	Board cur = *b;
+	if (flip) mirror_board(&cur);
+
+	BookPos* p = &positions[n_positions++];
+	p->key   = key;
+	p->board = cur;
+	p->ply   = ply;
+
+	for (int c = 0; c < COLS; c++) {
+		Board child = cur;
+		if (game_drop(&child, c, child.current) == -1)
+			continue;
+		child.current = (child.current == 'A') ? 'B' : 'A';
+		collect(&child, ply + 1, plies);
+	}
+}
+
+// Deepest positions first: they are the cheapest and leave exact entries
+// in the TT for the shallower ones
+static int by_ply_desc(const void* a, const void* b) {
+	return ((const BookPos*)b)->ply - ((const BookPos*)a)->ply;
+}
+
+static int by_entry(const void* a, const void* b) {
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+int main(int argc, char** argv) {
+	int         plies  = (argc > 1) ? atoi(argv[1]) : BOOK_PLIES;
+	const char* path   = (argc > 2) ? argv[2] : BOOK_FILE;
+	const char* prefix = (argc > 3) ? argv[3] : "";
+
+	if (plies < 1 || plies > ROWS * COLS) {
+		fprintf(stderr, "usage: %s [plies] [file] [prefix]\n", argv[0]);
+		return 2;
+	}
+
+	Board root;
+	initializeBoard(&root, 'A');
+	if (game_play_moves(&root, prefix) < 0)
+		die("invalid prefix");
+
+	zobrist_init();
+	tt_open(NULL);
+
+	collect(&root, __builtin_popcountll(root.mask), plies);
+	qsort(positions, n_positions, sizeof(BookPos), by_ply_desc);
+	fprintf(stderr, "bookgen: %zu positions below %d plies\n", n_positions, plies);
+
+	uint64_t* entries = malloc((n_positions ? n_positions : 1) * sizeof(uint64_t));
+	if (!entries) die("out of memory");
+
+	size_t done = 0;
+#pragma omp parallel for schedule(dynamic, 1)
+	for (size_t i = 0; i < n_positions; i++) {
+		Board b = positions[i].board;
+		SolveResult r;
+		solve_position(&b, SOLVE_STRONG, &r);
+		entries[i] = book_entry(positions[i].key, r.score, r.best_move);
+
+#pragma omp critical(bookgen_progress)
+		{
+			if (++done % 1000 == 0 || done == n_positions)
+				fprintf(stderr, "\rbookgen: solved %zu/%zu", done, n_positions);
+		}
+	}
+	fprintf(stderr, "\n");
+
+	qsort(entries, n_positions, sizeof(uint64_t), by_entry);
+
+	BookHeader h;
+	memset(&h, 0, sizeof h);
+	memcpy(h.magic, BOOK_FILE_MAGIC, 4);
+	h.version     = BOOK_FILE_VERSION;
+	h.plies       = (uint32_t)plies;
+	h.entry_bytes = sizeof(uint64_t);
+	h.count       = n_positions;
+
+	FILE* f = fopen(path, "wb");
+	if (!f || fwrite(&h, sizeof h, 1, f) != 1 ||
+	    fwrite(entries, sizeof(uint64_t), n_positions, f) != n_positions ||
+	    fclose(f) != 0)
+		die("cannot write book");
+
+	printf("Wrote %zu entries to %s\n", n_positions, path);
+
+	free(entries);
+	free(positions);
+	free(seen);
+	tt_free();
+	return 0;
+}
@@ -1,6 +1,7 @@
 #include "gamelogic.h"
 #include "bot.h"
-#include "history.h"
+#include "book.h"
+#include "tt.h"
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -16,9 +17,6 @@
 // CONFIG
 // -----------------------------------------------------------------------------
 
-// Transposition table size: 2^22 entries (~100MB) – you can raise to 1<<24 (~400MB) if you want
-#define TT_SIZE      (1 << 22)
-
 // Depth for *interactive* hard bot (pick_best_move).
 // 14–20 is usually a good balance; raise if it's fast enough on your machine.
 #define MAX_DEPTH    14
@@ -28,11 +26,9 @@
 // when the game ends before depth runs out.
 #define SOLVE_DEPTH  42
 
-// Verbose logging: set to 1 if you want detailed console output, 0 for speed
-#define BOT_VERBOSE  0
-
-// Max threads (only used if OpenMP is enabled)
-#define BOT_MAX_THREADS 6
+// Upper bound on Lazy SMP search threads (only used if OpenMP is enabled).
+// The default is one thread per available core, see bot_set_threads().
+#define BOT_MAX_THREADS 64
 
 // -----------------------------------------------------------------------------
 // CONSTANTS & GLOBALS
@@ -40,32 +36,74 @@
 
 static const int column_order[7] = {3, 4, 2, 5, 1, 6, 0};  // center-first ordering
 
-// Number of red stones and yellow stones in the center column
-static int red_stones = 0;
-static int yellow_stones = 0;
+// Fast "mate" scores; must fit the 16-bit value field of a TT entry
+static const int MATE = 30000;
 
-// Fast "mate" scores
-static const int MATE = 10000000;
+// Lazy SMP thread count for pick_best_move (0 = one per core)
+static int bot_threads = 0;
 
-// Node / TT stats (for debugging / info). These are accumulated totals.
-static unsigned long long nodes_searched = 0;
-static unsigned long long tt_hits        = 0;
+// Canonicalize TT keys under left-right reflection (see tt_key)
+static int bot_symmetry = 1;
 
-// Zobrist hashing
-static uint64_t zobrist[2][42];   // [playerIndex][squareIndex]
-static uint64_t zobrist_side;     // side-to-move key
+// Hot per-thread counters, summed into BotStats when the search ends.
+// Padded to a cache line so threads never write to a shared line.
+typedef struct {
+    unsigned long long nodes;
+    unsigned long long tt_probes;
+    unsigned long long tt_hits;        // probes that returned a usable value
+    unsigned long long tt_stores;
+    unsigned long long cutoffs;        // beta cutoffs
+    unsigned long long first_cutoffs;  // ... on the first move searched
+} __attribute__((aligned(64))) SearchCounters;
+
+// Per-thread search state. Every Lazy SMP thread owns one, so the hot
+// counters never bounce between cores.
+typedef struct {
+    SearchCounters     count;
+    int*               stop;         // this search's stop flag, NULL = never stop
+    const int*         cancel;       // outside stop request, NULL = none
+    long long          deadline_ns;  // monotonic clock deadline, 0 = none
+    unsigned long long node_limit;   // this thread's node budget, 0 = none
+    int                eval;         // BOT_EVAL_* used at the depth limit
+    unsigned           tt_age;       // this search's TT generation (tt_new_search)
+} SearchCtx;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
 
-typedef enum { EXACT, LOWERBOUND, UPPERBOUND } TTFlag;
+static inline int search_stopped(const SearchCtx* ctx) {
+    return (ctx->stop && __atomic_load_n(ctx->stop, __ATOMIC_RELAXED)) ||
+           (ctx->cancel && __atomic_load_n(ctx->cancel, __ATOMIC_RELAXED));
+}
 
-typedef struct {
-    uint64_t      key;
-    int           value;
-    int           depth;
-    unsigned char best_move;
-    unsigned char flag;
-} TTEntry;
+// Polled every 1024 nodes: raise the stop flag once the budget is spent
+static void search_check_budget(SearchCtx* ctx) {
+    if (!ctx->stop) return;
+    if ((ctx->deadline_ns && now_ns() >= ctx->deadline_ns) ||
+        (ctx->node_limit && ctx->count.nodes >= ctx->node_limit)) {
+        __atomic_store_n(ctx->stop, 1, __ATOMIC_RELAXED);
+    }
+}
 
-static TTEntry* tt = NULL;
+// Zobrist hashing. Squares are indexed like the bitboard (row + col * 7),
+// so there are 7 * 7 slots including the unused sentinel row.
+#define ZOBRIST_SQUARES (COLS * 7)
+#define ZOBRIST_SEED    0xC0441EC7C0441EC7ULL
+
+static uint64_t zobrist[2][ZOBRIST_SQUARES];   // [playerIndex][squareIndex]
+static uint64_t zobrist_mirror[2][ZOBRIST_SQUARES]; // key of the reflected square
+static uint64_t zobrist_side;                  // side-to-move key
+static uint64_t zobrist_eval[2];               // [BOT_EVAL_*] salt, 0 for the default
+
+// A position's key together with the key of its mirror image. Both are
+// updated incrementally; the TT is addressed with the smaller of the two.
+typedef struct {
+    uint64_t key;
+    uint64_t mirror;
+} PosKey;
 
 // -----------------------------------------------------------------------------
 // BITBOARD & MOVE HELPERS
@@ -94,12 +132,10 @@ static inline int bitboard_win(uint64_t bb) {
     return 0;
 }
 
-// Initialize heights[] from a Board using the normal game logic
+// Initialize heights[] from a Board: landing row per column, -1 if full
 static void init_heights(const Board* b, int heights[COLS]) {
-    for (int c = 0; c < COLS; c++) {
-        int r = game_can_drop(b, c);   // -1 if full, else landing row
-        heights[c] = r;
-    }
+    for (int c = 0; c < COLS; c++)
+        heights[c] = game_landing_row(b, c);
 }
 
 // Can we play in this column? (heights-based)
@@ -145,122 +181,90 @@ static inline void undo_move(Board* b, int heights[COLS], int col) {
 // ZOBRIST & TT
 // -----------------------------------------------------------------------------
 
-void zobrist_init() {
-    srand((unsigned)time(NULL));
-    for (int p = 0; p < 2; p++) {
-        for (int i = 0; i < 42; i++) {
-            // 64-bit random
-            uint64_t hi  = (uint64_t)(rand() & 0xFFFF);
-            uint64_t mid = (uint64_t)(rand() & 0xFFFF);
-            uint64_t lo  = (uint64_t)(rand() & 0xFFFF);
-            zobrist[p][i] = (hi << 48) ^ (mid << 32) ^ lo;
-        }
-    }
-    {
-        uint64_t hi  = (uint64_t)(rand() & 0xFFFF);
-        uint64_t mid = (uint64_t)(rand() & 0xFFFF);
-        uint64_t lo  = (uint64_t)(rand() & 0xFFFF);
-        zobrist_side = (hi << 48) ^ (mid << 32) ^ lo;
-    }
-}
-
-void tt_init() {
-    tt = (TTEntry*)calloc(TT_SIZE, sizeof(TTEntry));
-    if (!tt) {
-        fprintf(stderr, "ERROR: Failed to allocate transposition table\n");
-        exit(1);
-    }
-
-    // Try to load persistent TT (optional)
-    FILE* f = fopen("tt.bin", "rb");
-    if (f) {
-        size_t read = fread(tt, sizeof(TTEntry), TT_SIZE, f);
-#if BOT_VERBOSE
-        printf("Loaded %zu TT entries from disk\n", read);
-#endif
-        fclose(f);
-    }
-}
-
-static void tt_save() {
-    if (!tt) return;
-    FILE* f = fopen("tt.bin", "wb");
-    if (f) {
-        fwrite(tt, sizeof(TTEntry), TT_SIZE, f);
-        fclose(f);
-#if BOT_VERBOSE
-        printf("Saved TT to disk\n");
-#endif
-    }
-}
+static void bitboard_init(void);
 
-static inline void tt_store(uint64_t key, int value, int depth, TTFlag flag, int best_move) {
-    size_t idx   = key & (TT_SIZE - 1);
-    TTEntry* e   = &tt[idx];
-
-    if (e->key == 0 || e->depth <= depth) {
-        e->key       = key;
-        e->value     = value;
-        e->depth     = depth;
-        e->best_move = (best_move < 0) ? 255 : (unsigned char)best_move;
-        e->flag      = (unsigned char)flag;
-    }
+// splitmix64: small, well-mixed 64-bit generator for the Zobrist keys
+static uint64_t splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
 }
 
-static inline int tt_probe(uint64_t key, int depth, int alpha, int beta,
-                           int* out_value, int* out_move) {
-    size_t idx = key & (TT_SIZE - 1);
-    TTEntry* e = &tt[idx];
-
-    if (e->key != key) return 0;
-
-    if (out_move && e->best_move != 255) {
-        *out_move = e->best_move;
+// Keys come from a fixed seed so every run (and every process sharing
+// tt.bin) hashes a position to the same key. Changing the seed or the
+// square layout changes the key scheme: bump TT_KEY_SCHEME in tt.h.
+void zobrist_init() {
+    uint64_t state = ZOBRIST_SEED;
+    for (int p = 0; p < 2; p++) {
+        for (int i = 0; i < ZOBRIST_SQUARES; i++) {
+            zobrist[p][i] = splitmix64(&state);
+        }
     }
+    zobrist_side = splitmix64(&state);
 
-    if (e->depth < depth) {
-        // Stored result is from a shallower search – still use move hint, but no bound
-        return 0;
-    }
+    // Depth-limited values depend on the leaf evaluation: searches with
+    // another variant use their own keys so they never share those entries.
+    // The default stays unsalted, which keeps tt.bin valid.
+    zobrist_eval[BOT_EVAL_BITBOARD] = 0;
+    zobrist_eval[BOT_EVAL_WINDOWS]  = splitmix64(&state);
 
-    int val = e->value;
-    if (e->flag == EXACT) {
-        *out_value = val;
-        return 1;
-    } else if (e->flag == LOWERBOUND) {
-        if (val > alpha) alpha = val;
-    } else if (e->flag == UPPERBOUND) {
-        if (val < beta) beta = val;
-    }
-    if (alpha >= beta) {
-        *out_value = val;
-        return 1;
+    for (int p = 0; p < 2; p++) {
+        for (int i = 0; i < ZOBRIST_SQUARES; i++) {
+            zobrist_mirror[p][i] = zobrist[p][i % 7 + (COLS - 1 - i / 7) * 7];
+        }
     }
 
-    return 0;
+    bitboard_init();
 }
 
-// Compute Zobrist key from scratch (used only at root)
-static uint64_t compute_key(const Board* b, char side) {
-    uint64_t key = 0;
+// Compute Zobrist keys from scratch (used only at root)
+static PosKey compute_key(const Board* b, char side) {
+    PosKey k = { 0, 0 };
     uint64_t bb;
 
     bb = b->playerA;
     while (bb) {
         int idx = __builtin_ctzll(bb);
-        key ^= zobrist[0][idx];
+        k.key    ^= zobrist[0][idx];
+        k.mirror ^= zobrist_mirror[0][idx];
         bb &= bb - 1;
     }
 
     bb = b->playerB;
     while (bb) {
         int idx = __builtin_ctzll(bb);
-        key ^= zobrist[1][idx];
+        k.key    ^= zobrist[1][idx];
+        k.mirror ^= zobrist_mirror[1][idx];
         bb &= bb - 1;
     }
 
-    if (side == 'B') key ^= zobrist_side;
-    return key;
+    if (side == 'B') {
+        k.key    ^= zobrist_side;
+        k.mirror ^= zobrist_side;
+    }
+    return k;
+}
+
+// Keys after sideIdx drops a stone on square idx
+static inline PosKey key_after(PosKey k, int sideIdx, int idx) {
+    k.key    ^= zobrist[sideIdx][idx] ^ zobrist_side;
+    k.mirror ^= zobrist_mirror[sideIdx][idx] ^ zobrist_side;
+    return k;
+}
+
+// TT key of a position: the smaller of its own and its mirror image's key,
+// so both orientations share one entry. *flip is set when the entry
+// describes the mirror image; moves then go through mirror_col. Either way
+// an entry under key(X) always describes X, so tables written with symmetry
+// on and off stay compatible.
+static inline uint64_t tt_key(PosKey k, int* flip) {
+    *flip = bot_symmetry && k.mirror < k.key;
+    return *flip ? k.mirror : k.key;
+}
+
+static inline int mirror_col(int col) {
+    return COLS - 1 - col;
 }
 
 // -----------------------------------------------------------------------------
@@ -270,23 +274,6 @@ static uint64_t compute_key(const Board* b, char side) {
 static inline int encode_win(int ply)  { return  MATE - ply; }
 static inline int encode_loss(int ply) { return -MATE + ply; }
 
-// Human-friendly text for scores (used in debug prints)
-static const char* score_to_string(int score, int ply) {
-    static char buf[64];
-    if (score > MATE - 1000) {
-        int moves_to_win = (MATE - score + ply + 1) / 2;
-        snprintf(buf, sizeof(buf), "WIN in %d", moves_to_win);
-    } else if (score < -MATE + 1000) {
-        int moves_to_loss = (MATE + score - ply + 1) / 2;
-        snprintf(buf, sizeof(buf), "LOSS in %d", moves_to_loss);
-    } else if (score == 0) {
-        snprintf(buf, sizeof(buf), "DRAW");
-    } else {
-        snprintf(buf, sizeof(buf), "Score %+d", score);
-    }
-    return buf;
-}
-
 // -----------------------------------------------------------------------------
 // SIMPLE POSITIONAL EVALUATION (for depth limit)
 // -----------------------------------------------------------------------------
@@ -320,8 +307,9 @@ static int eval_window(const Board* b, int r, int c, int dr, int dc, char side)
     return score;
 }
 
-// Basic heuristic evaluation from the POV of 'side'
-static int evaluate(const Board* b, char side) {
+// Basic heuristic evaluation from the POV of 'side'. Kept as the
+// BOT_EVAL_WINDOWS reference for evaluate_bitboard below.
+static int evaluate_windows(const Board* b, char side) {
     int score = 0;
 
     // Center column preference (encourage occupying column 3)
@@ -362,6 +350,151 @@ static int evaluate(const Board* b, char side) {
     return score;
 }
 
+// -----------------------------------------------------------------------------
+// BITBOARD EVALUATION
+// -----------------------------------------------------------------------------
+
+// The same window scoring as evaluate_windows, but every window of a
+// direction is counted at once: shifting a bitboard by 0..3 steps lines the
+// four cells of each window up on the window's start square, and a
+// bit-sliced adder turns those four planes into "exactly 1/2/3 stones"
+// masks. Threat squares add an odd/even row parity bonus on top.
+
+// Window directions as bit shifts: vertical, horizontal, "\" and "/"
+static const int window_shift[4] = {1, 7, 8, 6};
+
+static uint64_t window_starts[4];  // start square of every full window
+static uint64_t odd_rows;          // rows 1, 3, 5 counted from the bottom
+static uint64_t center_bits;       // column 4
+
+static void bitboard_init(void) {
+    odd_rows = center_bits = 0;
+    for (int d = 0; d < 4; d++) window_starts[d] = 0;
+
+    for (int c = 0; c < COLS; c++) {
+        for (int r = 0; r < ROWS; r++) {
+            uint64_t bit = 1ULL << (r + c * 7);
+            if ((ROWS - r) & 1) odd_rows    |= bit;
+            if (c == 3)         center_bits |= bit;
+
+            int down = (r <= ROWS - 4), up = (r >= 3), right = (c <= COLS - 4);
+            if (down)          window_starts[0] |= bit;
+            if (right)         window_starts[1] |= bit;
+            if (down && right) window_starts[2] |= bit;
+            if (up && right)   window_starts[3] |= bit;
+        }
+    }
+}
+
+// Stone counts of the windows starting at each square of direction `s`
+static inline void window_counts(uint64_t x, int s, uint64_t* any,
+                                 uint64_t* one, uint64_t* two, uint64_t* three) {
+    uint64_t a = x, b = x >> s, c = x >> (2 * s), d = x >> (3 * s);
+    uint64_t s1 = a ^ b, c1 = a & b;
+    uint64_t s2 = c ^ d, c2 = c & d;
+    uint64_t ones  = s1 ^ s2;
+    uint64_t twos  = c1 ^ c2 ^ (s1 & s2);
+    *any   = a | b | c | d;
+    *one   = ones & ~twos;
+    *two   = twos & ~ones;
+    *three = ones & twos;
+}
+
+// Empty squares that would complete four for the stones in p. "Up" is
+// towards row 0, i.e. the lower bit; the always-empty sentinel bit of each
+// column stops shifted lines from wrapping into the next column.
+static inline uint64_t winning_squares(uint64_t p, uint64_t mask) {
+    uint64_t r = (p >> 1) & (p >> 2) & (p >> 3);   // vertical
+
+    for (int i = 1; i < 4; i++) {
+        int s = window_shift[i];
+        uint64_t t = (p << s) & (p << (2 * s));
+        r |= t & (p << (3 * s));
+        r |= t & (p >> s);
+        t = (p >> s) & (p >> (2 * s));
+        r |= t & (p << s);
+        r |= t & (p >> (3 * s));
+    }
+    return r & (GAME_BOARD_MASK ^ mask);
+}
+
+static int evaluate_bitboard(const Board* b, char side) {
+    uint64_t me  = (side == 'A') ? b->playerA : b->playerB;
+    uint64_t opp = (side == 'A') ? b->playerB : b->playerA;
+
+    // Center column preference
+    int score = 3 * (__builtin_popcountll(me & center_bits) -
+                     __builtin_popcountll(opp & center_bits));
+
+    for (int d = 0; d < 4; d++) {
+        int s = window_shift[d];
+        uint64_t me_any, me1, me2, me3, opp_any, opp1, opp2, opp3;
+        window_counts(me,  s, &me_any,  &me1,  &me2,  &me3);
+        window_counts(opp, s, &opp_any, &opp1, &opp2, &opp3);
+
+        uint64_t mine   = window_starts[d] & ~opp_any;  // windows we can still fill
+        uint64_t theirs = window_starts[d] & ~me_any;
+
+        score += 100 * __builtin_popcountll(me3 & mine)
+               +  10 * __builtin_popcountll(me2 & mine)
+               +       __builtin_popcountll(me1 & mine);
+        score -= 120 * __builtin_popcountll(opp3 & theirs);
+    }
+
+    // Threat parity: the player who moved first profits from threats on odd
+    // rows, the other player from threats on even rows (zugzwang at the end)
+    uint64_t my_rows = (__builtin_popcountll(b->mask) & 1) ? (GAME_BOARD_MASK ^ odd_rows) : odd_rows;
+    uint64_t my_threats  = winning_squares(me,  b->mask);
+    uint64_t opp_threats = winning_squares(opp, b->mask);
+    score += 80 * __builtin_popcountll(my_threats & my_rows);
+    score -= 80 * __builtin_popcountll(opp_threats & ~my_rows);
+
+    return score;
+}
+
+static inline int evaluate(const Board* b, char side, int variant) {
+    return (variant == BOT_EVAL_WINDOWS) ? evaluate_windows(b, side)
+                                         : evaluate_bitboard(b, side);
+}
+
+int bot_evaluate(const Board* b, char side, int variant) {
+    return evaluate(b, side, variant);
+}
+
+// -----------------------------------------------------------------------------
+// MOVE ORDERING
+// -----------------------------------------------------------------------------
+
+// Fills moves[] with the columns of `candidates`, best first: the TT move,
+// then descending threat count (winning squares after the move). Insertion
+// into a list built in column_order keeps ties center-first. Returns the
+// number of moves.
+static inline int order_moves(uint64_t me, uint64_t mask, uint64_t candidates,
+                              int tt_move, int moves[COLS]) {
+    int scores[COLS];
+    int n = 0;
+
+    for (int i = 0; i < COLS; i++) {
+        int c = column_order[i];
+        uint64_t mv = candidates & GAME_COL_MASK(c);
+        if (!mv) continue;
+
+        int score = (c == tt_move)
+                  ? COLS * ROWS
+                  : __builtin_popcountll(winning_squares(me | mv, mask | mv));
+
+        int k = n++;
+        while (k > 0 && scores[k - 1] < score) {
+            moves[k]  = moves[k - 1];
+            scores[k] = scores[k - 1];
+            k--;
+        }
+        moves[k]  = c;
+        scores[k] = score;
+    }
+    return n;
+}
+
 // -----------------------------------------------------------------------------
 // NEGAMAX + TT
 // -----------------------------------------------------------------------------
@@ -369,69 +502,83 @@ static int evaluate(const Board* b, char side) {
 static int negamax_solve(Board* b,
                          int alpha, int beta,
                          char side, int ply, int depth,
-                         uint64_t key,
+                         PosKey pk,
                          int heights[COLS],
-                         unsigned long long* nodes_count,
-                         unsigned long long* tt_hits_count)
+                         SearchCtx* ctx)
 {
-    (*nodes_count)++;
+    ctx->count.nodes++;
+    if ((ctx->count.nodes & 1023) == 0) search_check_budget(ctx);
+
+    // Budget spent or search finished elsewhere: unwind, the value is discarded
+    if (search_stopped(ctx)) return 0;
 
     // Transposition table probe
+    int flip;
+    uint64_t key = tt_key(pk, &flip);
     int tt_val;
     int tt_move = -1;
-    if (tt && tt_probe(key, depth, alpha, beta, &tt_val, &tt_move)) {
-        (*tt_hits_count)++;
+    ctx->count.tt_probes++;
+    if (tt_table && tt_probe(key, depth, alpha, beta, &tt_val, &tt_move)) {
+        ctx->count.tt_hits++;
         return tt_val;
     }
+    if (flip && tt_move >= 0) tt_move = mirror_col(tt_move);
 
     uint64_t meBB  = (side == 'A') ? b->playerA : b->playerB;
     uint64_t oppBB = (side == 'A') ? b->playerB : b->playerA;
 
-    // Terminal checks (wins)
-    if (bitboard_win(meBB)) {
-        return encode_win(ply);
-    }
+    // The previous move completed four (only possible below the root, where
+    // the parent's win-in-1 check didn't run)
     if (bitboard_win(oppBB)) {
-        return encode_loss(ply);
+        return encode_loss(ply - 1);
     }
 
-    // Depth limit: use evaluation
-    if (depth <= 0) {
-        return evaluate(b, side);
+    uint64_t possible = game_playable(b);
+    if (!possible) {
+        // No legal moves: draw
+        return 0;
     }
 
-    // Generate moves
-    int moves[COLS];
-    int n = 0;
-
-    // If TT suggested a move, try it first
-    if (tt_move >= 0 && can_play(b, heights, tt_move)) {
-        moves[n++] = tt_move;
+    // Win-in-1 pruning: side can complete four right now
+    uint64_t my_wins = winning_squares(meBB, b->mask) & possible;
+    if (my_wins) {
+        int score = encode_win(ply);
+        int c     = __builtin_ctzll(my_wins) / 7;
+        if (tt_table) tt_store(key, score, depth, EXACT, flip ? mirror_col(c) : c, ctx->tt_age);
+        ctx->count.tt_stores++;
+        return score;
     }
 
-    // Add other moves in preferred order
-    for (int i = 0; i < COLS; i++) {
-        int c = column_order[i];
-        if (c == tt_move) continue;
-        if (can_play(b, heights, c)) moves[n++] = c;
+    // Forced moves: every opponent threat we can reach must be blocked now.
+    // Two of them can't both be blocked, so the opponent wins next ply.
+    uint64_t opp_wins = winning_squares(oppBB, b->mask);
+    uint64_t forced   = possible & opp_wins;
+    if (forced) {
+        if (forced & (forced - 1)) return encode_loss(ply + 1);
+        possible = forced;
     }
 
-    if (n == 0) {
-        // No legal moves: draw
-        return 0;
+    // Never play directly under an opponent threat: it hands them the square
+    uint64_t candidates = possible & ~(opp_wins << 1);
+    if (!candidates) return encode_loss(ply + 1);
+
+    // Depth limit: use evaluation
+    if (depth <= 0) {
+        return evaluate(b, side, ctx->eval);
     }
 
-    // Win-in-1 pruning: check if side can win immediately
-    for (int i = 0; i < n; i++) {
-        int c = moves[i];
-        uint64_t mv = move_bit_for_col(heights, c);
-        if (bitboard_win(meBB | mv)) {
-            int score = encode_win(ply);
-            if (tt) tt_store(key, score, depth, EXACT, c);
-            return score;
-        }
+    // No win with this stone, so the best left is a win with our next one
+    int max_score = encode_win(ply + 2);
+    if (beta > max_score) {
+        beta = max_score;
+        if (alpha >= beta) return beta;
     }
 
+    // Generate moves: TT move first, then by how many winning squares the
+    // move leaves us with; column_order breaks ties towards the center
+    int moves[COLS];
+    int n = order_moves(meBB, b->mask, candidates, tt_move, moves);
+
     int best      = -MATE;
     int best_move = moves[0];
     int alphaOrig = alpha;
@@ -440,31 +587,36 @@ static int negamax_solve(Board* b,
     for (int i = 0; i < n; i++) {
         int c = moves[i];
 
-        // Update key incrementally:
+        // Update keys incrementally:
         // piece index is (heights[c]) before apply_move
         int row     = heights[c];
         int idx     = row + c * 7;
         int sideIdx = (side == 'A') ? 0 : 1;
 
-        uint64_t childKey = key;
-        childKey ^= zobrist[sideIdx][idx];  // add piece
-        childKey ^= zobrist_side;           // flip side to move
-
+        PosKey child = key_after(pk, sideIdx, idx);
+        int child_flip;
+        tt_prefetch(tt_key(child, &child_flip));
         apply_move(b, heights, c, side);
         int val = -negamax_solve(b, -beta, -alpha,
                                  next_side, ply + 1, depth - 1,
-                                 childKey,
+                                 child,
                                  heights,
-                                 nodes_count,
-                                 tt_hits_count);
+                                 ctx);
         undo_move(b, heights, c);
 
+        // Aborted subtree: its value is meaningless, don't let it reach the TT
+        if (search_stopped(ctx)) return 0;
+
         if (val > best) {
             best      = val;
             best_move = c;
         }
         if (best > alpha) alpha = best;
-        if (alpha >= beta) break;  // beta cutoff
+        if (alpha >= beta) {       // beta cutoff
+            ctx->count.cutoffs++;
+            if (i == 0) ctx->count.first_cutoffs++;
+            break;
+        }
     }
 
     // Store to TT
@@ -473,302 +625,459 @@ static int negamax_solve(Board* b,
     else if (best >= beta)      flag = LOWERBOUND;
     else                        flag = EXACT;
 
-    if (tt) tt_store(key, best, depth, flag, best_move);
+    if (tt_table) tt_store(key, best, depth, flag, flip ? mirror_col(best_move) : best_move,
+                           ctx->tt_age);
+    ctx->count.tt_stores++;
 
     return best;
 }
 
+// -----------------------------------------------------------------------------
+// SEARCH STATISTICS
+// -----------------------------------------------------------------------------
+
+static void stats_add(BotStats* s, const SearchCounters* c) {
+    s->nodes         += c->nodes;
+    s->tt_probes     += c->tt_probes;
+    s->tt_hits       += c->tt_hits;
+    s->tt_stores     += c->tt_stores;
+    s->cutoffs       += c->cutoffs;
+    s->first_cutoffs += c->first_cutoffs;
+}
+
+// x^(1/n) by bisection, which keeps libm out of the build
+static double nth_root(double x, int n) {
+    double lo = 1.0, hi = x;
+    for (int it = 0; it < 64; it++) {
+        double mid = 0.5 * (lo + hi), p = 1.0;
+        for (int k = 0; k < n && p <= x; k++) p *= mid;
+        if (p > x) hi = mid;
+        else       lo = mid;
+    }
+    return lo;
+}
+
+// Derived figures, once every thread's counters are in. The branching
+// factor uses the nodes of one thread's tree: N = b^depth.
+static void stats_finish(BotStats* s) {
+    s->first_cutoff_rate = s->cutoffs ? (double)s->first_cutoffs / (double)s->cutoffs : 0.0;
+    if (s->depth > 0 && s->threads > 0 && s->nodes > (unsigned long long)s->threads)
+        s->ebf = nth_root((double)s->nodes / s->threads, s->depth);
+}
+
+void bot_stats_print_json(FILE* out, const char* search, int move, const BotStats* s) {
+    fprintf(out,
+            "{\"search\": \"%s\", \"move\": %d, \"book\": %d, \"ponder\": %d, \"depth\": %d, \"threads\": %d, "
+            "\"nodes\": %llu, \"tt_probes\": %llu, \"tt_hits\": %llu, \"tt_stores\": %llu, "
+            "\"cutoffs\": %llu, \"first_cutoff_rate\": %.4f, \"ebf\": %.3f, "
+            "\"elapsed_ns\": %lld, \"knodes_per_s\": %.1f}\n",
+            search, move + 1, s->book, s->ponder, s->depth, s->threads,
+            s->nodes, s->tt_probes, s->tt_hits, s->tt_stores,
+            s->cutoffs, s->first_cutoff_rate, s->ebf,
+            s->elapsed_ns, s->elapsed_ns > 0 ? s->nodes * 1e6 / (double)s->elapsed_ns : 0.0);
+    fflush(out);
+}
+
 // -----------------------------------------------------------------------------
 // SOLVER INTERFACE
 // -----------------------------------------------------------------------------
 
-int solve_position(Board* b) {
+// Scores in the solver API use the usual Connect 4 convention instead of
+// the raw MATE - ply values: a win whose winning stone is played when p
+// stones are on the board scores (43 - p) / 2, a loss the negative of that,
+// a draw 0. So the faster the win, the higher the score.
+static int raw_to_score(int raw) {
+    if (raw > MATE - 1000) return  (ROWS * COLS + 1 - (MATE - raw)) / 2;
+    if (raw < -MATE + 1000) return -(ROWS * COLS + 1 - (MATE + raw)) / 2;
+    return 0;
+}
+
+// Smallest raw value whose score is >= s
+static int score_threshold(int s) {
+    if (s > 0) return MATE - (ROWS * COLS + 1) + 2 * s;
+    if (s < 0) return -MATE + ROWS * COLS + 2 * s;
+    return 0;
+}
+
+// Full-depth search of b with window (alpha, beta); depth = squares left,
+// so TT entries from any search that reached the end of the game are exact
+static int solve_window(Board* b, int alpha, int beta, SearchCtx* ctx) {
     int heights[COLS];
     init_heights(b, heights);
+    int ply = __builtin_popcountll(b->mask);
+    PosKey pk = compute_key(b, b->current);
+    return negamax_solve(b, alpha, beta, b->current, ply, ROWS * COLS - ply,
+                         pk, heights, ctx);
+}
+
+// Raw value of playing col, as seen from the side to move, tested against
+// the null window at `threshold`: the result is >= threshold iff the move
+// reaches it.
+static int solve_child(Board* b, int col, int threshold, SearchCtx* ctx) {
     char side = b->current;
-    uint64_t key = compute_key(b, side);
+    game_drop(b, col, side);
+    b->current = (side == 'A') ? 'B' : 'A';
+
+    int val;
+    if (bitboard_win((side == 'A') ? b->playerA : b->playerB))
+        val = encode_win(__builtin_popcountll(b->mask) - 1);
+    else
+        val = -solve_window(b, -threshold, -threshold + 1, ctx);
+
+    b->current = side;
+    setChar(b, game_can_drop(b, col) + 1, col, EMPTY);
+    return val;
+}
 
-    nodes_searched = 0;
-    tt_hits        = 0;
+// First move (in search order) whose value reaches `threshold`
+static int solve_best_move(Board* b, int threshold, SearchCtx* ctx) {
+    uint64_t me = (b->current == 'A') ? b->playerA : b->playerB;
+    int moves[COLS];
+    int n = order_moves(me, b->mask, game_playable(b), -1, moves);
 
-    int res = negamax_solve(b, -MATE, MATE, side, 0, SOLVE_DEPTH, key,
-                            heights, &nodes_searched, &tt_hits);
+    for (int i = 0; i < n; i++) {
+        if (solve_child(b, moves[i], threshold, ctx) >= threshold)
+            return moves[i];
+    }
+    return n ? moves[0] : -1;
+}
 
-#if BOT_VERBOSE
-    printf("Solve stats: nodes=%llu, tt_hits=%llu (%.1f%%)\n",
-           nodes_searched, tt_hits,
-           nodes_searched ? (100.0 * tt_hits / nodes_searched) : 0.0);
-#endif
+// Weak mode only decides win / draw / loss with one (-1, 1) window search.
+// Strong mode narrows the exact score by bisection: each step is a null
+// window search "score > med?" that reuses everything the previous steps
+// left in the TT. Like the bot, it needs tt_init()/tt_open() first to be
+// fast; it is reentrant, so several threads may solve at once.
+int solve_position(Board* b, SolveMode mode, SolveResult* out) {
+    SearchCtx ctx = { .stop = NULL, .eval = BOT_EVAL_BITBOARD, .tt_age = tt_current_age() };
+    long long start = now_ns();
+    int ply = __builtin_popcountll(b->mask);
+    int score, best;
+
+    if (!game_playable(b)) {
+        score = 0;
+        best  = -1;
+    } else if (mode == SOLVE_WEAK) {
+        int raw = solve_window(b, -1, 1, &ctx);
+        score = (raw > 0) - (raw < 0);
+        best  = solve_best_move(b, score > 0 ? 1 : (score == 0 ? 0 : -MATE), &ctx);
+    } else {
+        int min = -(ROWS * COLS - ply) / 2;
+        int max = (ROWS * COLS + 1 - ply) / 2;
+        while (min < max) {
+            // Probe near 0 first: early positions are mostly close to a draw
+            int med = min + (max - min) / 2;
+            if (med <= 0 && min / 2 < med)      med = min / 2;
+            else if (med >= 0 && max / 2 > med) med = max / 2;
+
+            // Fail-soft: the returned value bounds the score beyond med
+            int t   = score_threshold(med + 1);
+            int raw = solve_window(b, t - 1, t, &ctx);
+            int r   = raw_to_score(raw);
+            if (raw >= t) min = (r > med + 1) ? r : med + 1;
+            else          max = (r < med) ? r : med;
+        }
+        score = min;
+        best  = solve_best_move(b, score_threshold(score), &ctx);
+    }
 
-    if (res > 0) return 1;
-    if (res < 0) return -1;
-    return 0;
+    if (out) {
+        out->score     = score;
+        out->best_move = best;
+        memset(&out->stats, 0, sizeof(out->stats));
+        stats_add(&out->stats, &ctx.count);
+        out->stats.depth      = ROWS * COLS - ply;
+        out->stats.threads    = 1;
+        out->stats.elapsed_ns = now_ns() - start;
+        stats_finish(&out->stats);
+    }
+    return score;
 }
 
 const char* solve_str(Board* b) {
-    int r = solve_position(b);
+    int r = solve_position(b, SOLVE_WEAK, NULL);
     if (r > 0) return "WIN for side to move";
     if (r < 0) return "LOSS for side to move";
     return "DRAW";
 }
 
 // -----------------------------------------------------------------------------
-// OPENING BOOK
+// MAIN HARD BOT: pick_best_move (iterative deepening, Lazy SMP with OpenMP)
 // -----------------------------------------------------------------------------
 
-static const int opening_book[][2] = {
-    {0,3}, {1,3}, {2,3}, {3,3}, {4,3}, {5,3}
-};
-static const int opening_book_size = 1; //was 6
-
-int opening_book_move(Board* b, int ply) {
-	// Normal book for early plies: always play center (col 3, 0-based)
-	if (ply >= 0 && ply < opening_book_size) {
-		int col = opening_book[ply][1];
-		if (game_can_drop(b, col) != -1){
-			red_stones++;
-			return col;
-		}
-		// If center somehow not playable, fall through to search / other book
-	}
-	else if (ply < 6){
-		Move last;
-		if (!history_get_last_move(&last))
-			return -1;          // no history? fall back to search
-
-		if (last.player != 'A')
-			return -1;          // last move must be human's
-
-		int human_col = last.col;  // 0..6
-
-		if (human_col == 3){
-			yellow_stones++;
-			return 3;
-		}
-	}
-
-	// Special book at ply 6: after human's 3rd move, bot to move
-	// Move order (bot starts as 'B'):
-	//   0: B, 1: A, 2: B, 3: A, 4: B, 5: A  → now ply == 6, current == 'B'
-	if (ply == 6 && b->current == 'B' && yellow_stones == 2 && red_stones == 1) {
-		Move last;
-		if (!history_get_last_move(&last))
-			return -1;          // no history? fall back to search
-
-		if (last.player != 'A')
-			return -1;          // last move must be human's
-
-		int human_col = last.col;  // 0..6
-
-		int options[2];
-		int num_opts = 0;
-
-		switch (human_col) {
-		case 0: // human played col 1
-			options[0] = 2; options[1] = 4; num_opts = 2; break; // bot: 3 or 5
-		case 1: // human played col 2
-			options[0] = 1; num_opts = 1; break;                 // bot: 2
-		case 2: // human played col 3
-			options[0] = 2; options[1] = 5; num_opts = 2; break; // bot: 3 or 6
-		case 3: // human played col 4
-			options[0] = 2; options[1] = 4; num_opts = 2; break; // bot: 3 or 5
-		case 4: // human played col 5
-			options[0] = 4; options[1] = 1; num_opts = 2; break; // bot: 5 or 2
-		case 5: // human played col 6
-			options[0] = 5; num_opts = 1; break;                 // bot: 6
-		case 6: // human played col 7
-			options[0] = 4; options[1] = 2; num_opts = 2; break; // bot: 5 or 3
-		default:
-			return -1;
-		}
-
-		if (num_opts == 0) return -1;
-
-		// Randomly choose among the options that are actually playable
-		if (num_opts == 1) {
-			int c = options[0];
-			if (game_can_drop(b, c) != -1)
-				return c;
-			return -1;
-		} else {
-			int i  = rand() % 2;
-			int c1 = options[i];
-			int c2 = options[1 - i];
-
-			if (game_can_drop(b, c1) != -1)
-				return c1;
-			if (game_can_drop(b, c2) != -1)
-				return c2;
-
-			return -1;
-		}
-	}
-
-	// No book for other plies
-	return -1;
+void bot_set_threads(int n) {
+    if (n > BOT_MAX_THREADS) n = BOT_MAX_THREADS;
+    bot_threads = (n < 0) ? 0 : n;
 }
-// -----------------------------------------------------------------------------
-// MAIN HARD BOT: pick_best_move (root-parallel with OpenMP)
-// -----------------------------------------------------------------------------
 
-int pick_best_move(Board* b) {
+int bot_get_threads(void) {
+    int n = bot_threads;
+#ifdef _OPENMP
+    if (n == 0) n = omp_get_num_procs();
+#else
+    n = 1;
+#endif
+    if (n > BOT_MAX_THREADS) n = BOT_MAX_THREADS;
+    return (n < 1) ? 1 : n;
+}
+
+int bot_tt_move(const Board* b) {
+    if (!tt_table) return -1;
+
+    int flip;
+    uint64_t key = tt_key(compute_key(b, b->current), &flip);
+    uint32_t d;
+    if (!tt_lookup(key, &d) || tt_data_move(d) == TT_NO_MOVE)
+        return -1;
+    int c = flip ? mirror_col(tt_data_move(d)) : tt_data_move(d);
+    return (game_can_drop(b, c) != -1) ? c : -1;
+}
+
+void bot_set_symmetry(int on) {
+    bot_symmetry = on;
+}
+
+// Search every root move to `depth` on a private copy of the board.
+// `rotate` shifts the root move order (after the first move) so Lazy SMP
+// helpers start in different subtrees. Returns the best value; the move
+// goes to *out_move. If the search is stopped midway the result must be
+// ignored.
+static int search_root(const Board* root, const int heights_root[COLS],
+                       PosKey pk, int ply, int depth,
+                       const int* moves, int n, int rotate,
+                       SearchCtx* ctx, int* out_move)
+{
+    Board b = *root;
+    int heights[COLS];
+    memcpy(heights, heights_root, sizeof(int) * COLS);
+
+    char side      = b.current;
+    char next_side = (side == 'A') ? 'B' : 'A';
+    int  sideIdx   = (side == 'A') ? 0 : 1;
+
+    int alpha     = -MATE;
+    int best_val  = -MATE;
+    int best_move = moves[0];
+
+    for (int k = 0; k < n; k++) {
+        int c = (k == 0 || n == 1) ? moves[0] : moves[1 + (k - 1 + rotate) % (n - 1)];
+
+        int idx = heights[c] + c * 7;
+        PosKey child = key_after(pk, sideIdx, idx);
+        int child_flip;
+
+        tt_prefetch(tt_key(child, &child_flip));
+        apply_move(&b, heights, c, side);
+        int val = -negamax_solve(&b, -MATE, -alpha,
+                                 next_side, ply + 1, depth - 1,
+                                 child, heights, ctx);
+        undo_move(&b, heights, c);
+
+        if (search_stopped(ctx)) break;
+
+        if (val > best_val) {
+            best_val  = val;
+            best_move = c;
+        }
+        if (best_val > alpha) alpha = best_val;
+    }
+
+    *out_move = best_move;
+    return best_val;
+}
+
+// Result of the deepest iteration any thread has completed
+typedef struct {
+    int depth;
+    int move;
+    int value;
+} RootResult;
+
+// One thread's iterative deepening loop. Each completed iteration publishes
+// its result if it is the deepest so far; the next iteration then searches
+// that move first. Thread 0 also decides when the search is over.
+static void search_iterate(const Board* b, const int heights_root[COLS],
+                           PosKey pk, int ply, const int* root_moves, int n,
+                           int max_depth, int tid, long long start_ns,
+                           int time_ms, SearchCtx* ctx, RootResult* result)
+{
+    int moves[COLS];
+    memcpy(moves, root_moves, sizeof(int) * n);
+
+    // Helpers skip every other depth on odd ids so the threads spread over
+    // two depths at a time instead of all racing on the same one
+    for (int depth = 1 + (tid & 1); depth <= max_depth; depth++) {
+        int move;
+        int val = search_root(b, heights_root, pk, ply, depth,
+                              moves, n, tid, ctx, &move);
+        if (search_stopped(ctx)) break;
+
+        int finished = 0;
+#pragma omp critical(bot_result)
+        {
+            if (depth > result->depth) {
+                result->depth = depth;
+                result->move  = move;
+                result->value = val;
+            }
+            // Known game result, or every remaining square searched: done
+            if (result->value > MATE - 1000 || result->value < -MATE + 1000 ||
+                result->depth >= max_depth)
+                finished = 1;
+            move = result->move;
+        }
+
+        // Seed the next iteration with the best completed move
+        for (int i = 1; i < n; i++) {
+            if (moves[i] == move) {
+                moves[i]  = moves[0];
+                moves[0]  = move;
+                break;
+            }
+        }
+
+        // The next iteration costs a few times this one: don't start it if
+        // it can't finish within the budget
+        if (tid == 0 && time_ms > 0 && now_ns() - start_ns > (long long)time_ms * 500000LL)
+            finished = 1;
+
+        if (finished) {
+            __atomic_store_n(ctx->stop, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        depth += (tid & 1);
+    }
+}
+
+int pick_best_move(Board* b, const BotLimits* limits, BotStats* stats) {
     int  ply  = __builtin_popcountll(b->mask);
     char side = b->current;
+    long long start = now_ns();
+
+    // Moves decided without a search report zero counters
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+        stats->threads = 1;
+    }
 
     int heights_root[COLS];
     init_heights(b, heights_root);
 
-#if BOT_VERBOSE
-    printf("\n[HARD BOT] Player %c, move %d/42\n", side, ply + 1);
-    printf("Legal moves:");
-    for (int c = 0; c < COLS; c++) {
-        if (can_play(b, heights_root, c)) printf(" %d", c + 1);
-    }
-    printf("\n");
-#endif
-
-    // Opening book: if move is playable, just use it
-    int book = opening_book_move(b, ply);
+    // Opening book: solved moves for the first plies, when book.bin is mapped
+    int book = book_lookup(b, NULL);
     if (book != -1 && can_play(b, heights_root, book)) {
-#if BOT_VERBOSE
-        printf("Using opening book move: column %d\n\n", book + 1);
-#endif
+        if (stats) stats->book = 1;
         return book;
     }
 
-    // Collect legal moves
+    int eval = (limits && limits->eval == BOT_EVAL_WINDOWS) ? BOT_EVAL_WINDOWS : BOT_EVAL_BITBOARD;
+    PosKey pk = compute_key(b, side);
+    pk.key    ^= zobrist_eval[eval];
+    pk.mirror ^= zobrist_eval[eval];
+    int flip;
+    uint64_t key = tt_key(pk, &flip);
+
+    // Root move filter, as in negamax_solve: take a win, block a threat,
+    // and skip moves under an opponent threat unless nothing else is left
+    uint64_t meBB     = (side == 'A') ? b->playerA : b->playerB;
+    uint64_t oppBB    = (side == 'A') ? b->playerB : b->playerA;
+    uint64_t possible = game_playable(b);
+    if (!possible) return -1;
+
+    uint64_t my_wins = winning_squares(meBB, b->mask) & possible;
+    if (my_wins) return __builtin_ctzll(my_wins) / 7;
+
+    uint64_t opp_wins = winning_squares(oppBB, b->mask);
+    if (possible & opp_wins) possible &= opp_wins;
+    if (possible & ~(opp_wins << 1)) possible &= ~(opp_wins << 1);
+
+    // Collect candidate moves: TT move first, then center first
+    int tt_move = -1;
+    if (tt_table) {
+        uint32_t d;
+        if (tt_lookup(key, &d) && tt_data_move(d) != TT_NO_MOVE)
+            tt_move = flip ? mirror_col(tt_data_move(d)) : tt_data_move(d);
+    }
     int moves[COLS];
     int n = 0;
-    for (int c = 0; c < COLS; c++) {
-        if (can_play(b, heights_root, c)) moves[n++] = c;
+    if (tt_move >= 0 && (possible & GAME_COL_MASK(tt_move))) moves[n++] = tt_move;
+    for (int i = 0; i < COLS; i++) {
+        int c = column_order[i];
+        if (c != tt_move && (possible & GAME_COL_MASK(c))) moves[n++] = c;
     }
-    if (n == 0) return -1;
 
-    uint64_t key = compute_key(b, side);
+    // A single candidate needs no search
+    if (n == 1) return moves[0];
 
-    nodes_searched = 0;
-    tt_hits        = 0;
+    // Budget: never deeper than the squares left to fill
+    int max_depth = (limits && limits->max_depth > 0) ? limits->max_depth : MAX_DEPTH;
+    if (max_depth > ROWS * COLS - ply) max_depth = ROWS * COLS - ply;
+    int time_ms = limits ? limits->time_ms : 0;
+    unsigned long long max_nodes = limits ? limits->max_nodes : 0;
 
-    int best_move = moves[0];
-    int best_val  = -MATE;
+    // Each call owns the flag its threads raise when the search is over, so
+    // concurrent searches never stop each other; the cancel flag is only read
+    int stop = 0;
+    static const int never = 0;
+    const int* cancel = (limits && limits->stop) ? limits->stop : &never;
 
-#if BOT_VERBOSE
-    printf("Searching to depth %d...\n", MAX_DEPTH);
-#endif
+    long long deadline = (time_ms > 0) ? start + (long long)time_ms * 1000000LL : 0;
+
+    unsigned age = tt_new_search();
+
+    RootResult result = { 0, moves[0], -MATE };
+    BotStats   total;
+    memset(&total, 0, sizeof(total));
 
 #ifdef _OPENMP
-    omp_set_num_threads(BOT_MAX_THREADS);
-#pragma omp parallel
+    int nthreads = bot_get_threads();
+
+    // Node budget split over the threads; never rounded down to 0 = none
+    unsigned long long thread_nodes = max_nodes / (unsigned long long)nthreads;
+    if (max_nodes && !thread_nodes)
+        thread_nodes = 1;
+
+    // Lazy SMP: every thread runs its own iterative deepening over the whole
+    // tree and they cooperate only through the shared TT. Helpers start from
+    // rotated root moves and staggered depths so they explore different
+    // subtrees and have TT entries ready before thread 0 needs them.
+#pragma omp parallel num_threads(nthreads)
     {
-        Board local_board;
-        int   local_heights[COLS];
-        unsigned long long local_nodes   = 0;
-        unsigned long long local_tt_hits = 0;
-        int   local_best_val  = -MATE;
-        int   local_best_move = -1;
-
-        // Parallel for over moves
-#pragma omp for schedule(dynamic)
-        for (int i = 0; i < n; i++) {
-            int c = moves[i];
-
-            // Copy board and heights for this thread's search
-            local_board = *b;
-            memcpy(local_heights, heights_root, sizeof(int) * COLS);
-
-            // Build child key
-            int row     = local_heights[c];
-            int idx     = row + c * 7;
-            int sideIdx = (side == 'A') ? 0 : 1;
-
-            uint64_t childKey = key;
-            childKey ^= zobrist[sideIdx][idx];
-            childKey ^= zobrist_side;
-
-            apply_move(&local_board, local_heights, c, side);
-            int val = -negamax_solve(&local_board,
-                                     -MATE, MATE,
-                                     (side == 'A') ? 'B' : 'A',
-                                     ply + 1, MAX_DEPTH - 1,
-                                     childKey,
-                                     local_heights,
-                                     &local_nodes,
-                                     &local_tt_hits);
-
-#if BOT_VERBOSE
-#pragma omp critical
-            {
-                printf("  Column %d: %s\n", c + 1, score_to_string(val, ply));
-            }
-#endif
+        int tid = omp_get_thread_num();
+        SearchCtx ctx = { .stop = &stop, .cancel = cancel, .deadline_ns = deadline,
+                          .node_limit = thread_nodes,
+                          .eval = eval, .tt_age = age };
 
-            if (val > local_best_val) {
-                local_best_val  = val;
-                local_best_move = c;
-            }
-        }
+        search_iterate(b, heights_root, pk, ply, moves, n, max_depth,
+                       tid, start, time_ms, &ctx, &result);
 
-        // Merge local stats & best into global
-#pragma omp critical
-        {
-            nodes_searched += local_nodes;
-            tt_hits        += local_tt_hits;
-            if (local_best_val > best_val) {
-                best_val  = local_best_val;
-                best_move = local_best_move;
-            }
-        }
+#pragma omp critical(bot_result)
+        stats_add(&total, &ctx.count);
     }
+    total.threads = nthreads;
 #else
     // Single-threaded fallback (no OpenMP)
-    for (int i = 0; i < n; i++) {
-        int c = moves[i];
-
-        int heights[COLS];
-        memcpy(heights, heights_root, sizeof(int) * COLS);
-        Board local_board = *b;
-
-        int row     = heights[c];
-        int idx     = row + c * 7;
-        int sideIdx = (side == 'A') ? 0 : 1;
-        uint64_t childKey = key ^ zobrist[sideIdx][idx] ^ zobrist_side;
-
-        unsigned long long local_nodes   = 0;
-        unsigned long long local_tt_hits = 0;
-
-        apply_move(&local_board, heights, c, side);
-        int val = -negamax_solve(&local_board,
-                                 -MATE, MATE,
-                                 (side == 'A') ? 'B' : 'A',
-                                 ply + 1, MAX_DEPTH - 1,
-                                 childKey,
-                                 heights,
-                                 &local_nodes,
-                                 &local_tt_hits);
-
-        nodes_searched += local_nodes;
-        tt_hits        += local_tt_hits;
-
-#if BOT_VERBOSE
-        printf("  Column %d: %s\n", c + 1, score_to_string(val, ply));
-#endif
-
-        if (val > best_val) {
-            best_val = val;
-            best_move = c;
-        }
+    {
+        SearchCtx ctx = { .stop = &stop, .cancel = cancel, .deadline_ns = deadline,
+                          .node_limit = max_nodes, .eval = eval, .tt_age = age };
+        search_iterate(b, heights_root, pk, ply, moves, n, max_depth,
+                       0, start, time_ms, &ctx, &result);
+        stats_add(&total, &ctx.count);
     }
+    total.threads = 1;
 #endif
 
-#if BOT_VERBOSE
-    printf("Search stats: nodes=%llu, tt_hits=%llu (%.1f%%)\n",
-           nodes_searched, tt_hits,
-           nodes_searched ? (100.0 * tt_hits / nodes_searched) : 0.0);
-    printf("Chosen move: column %d (%s)\n\n",
-           best_move + 1, score_to_string(best_val, ply));
-#endif
+    if (tt_table && result.depth > 0)
+        tt_store(key, result.value, result.depth, EXACT,
+                 flip ? mirror_col(result.move) : result.move, age);
+
+    if (stats) {
+        total.depth      = result.depth;
+        total.elapsed_ns = now_ns() - start;
+        stats_finish(&total);
+        *stats = total;
+    }
 
-    return best_move;
+    return result.move;
 }
 
 // -----------------------------------------------------------------------------
@@ -776,33 +1085,42 @@ int pick_best_move(Board* b) {
 // -----------------------------------------------------------------------------
 
 void shutdown_bot() {
-    tt_save();
-    free(tt);
-    tt = NULL;
+    tt_free();
+    book_close();
 }
 
 // Random bot (easy)
+// Draws from *seed with rand_r, or from rand() when seed is NULL
+static int bot_rand(unsigned* seed) {
+    return seed ? rand_r(seed) : rand();
+}
+
 int bot_choose_move(const Board* g) {
-    int valid[COLS];
-    int n = 0;
-    for (int c = 0; c < COLS; c++) {
-        if (getChar(g, 0, c) == EMPTY) {
-            valid[n++] = c;
-        }
-    }
-    if (n == 0) return -1;
-    return valid[rand() % n];
+    return bot_choose_move_r(g, NULL);
+}
+
+int bot_choose_move_r(const Board* g, unsigned* seed) {
+    int legal = game_legal_moves(g);
+    if (!legal) return -1;
+    // The k-th open column, counting from the left
+    for (int k = bot_rand(seed) % __builtin_popcount(legal); k > 0; k--)
+        legal &= legal - 1;
+    return __builtin_ctz(legal);
 }
 
 // Medium bot: blocks immediate wins + random
 int bot_choose_move_medium(const Board* g) {
+    return bot_choose_move_medium_r(g, NULL);
+}
+
+int bot_choose_move_medium_r(const Board* g, unsigned* seed) {
     int blocking[COLS];
     int nb = 0;
-    char human = 'A';
+    char human = (g->current == 'A') ? 'B' : 'A';
 
-    for (int c = 0; c < COLS; c++) {
-        int r = game_can_drop(g, c);
-        if (r == -1) continue;
+    for (int legal = game_legal_moves(g); legal; legal &= legal - 1) {
+        int c = __builtin_ctz(legal);
+        int r = game_landing_row(g, c);
 
         Board tmp = *g;
         setChar(&tmp, r, c, human);
@@ -812,8 +1130,8 @@ int bot_choose_move_medium(const Board* g) {
     }
 
     if (nb > 0) {
-        return blocking[rand() % nb];
+        return blocking[bot_rand(seed) % nb];
     }
 
-    return bot_choose_move(g);
+    return bot_choose_move_r(g, seed);
 }
@@ -5,11 +5,78 @@
 
 #include "gamelogic.h"
 
+#include <stdio.h>
+
 int bot_choose_move(const Board* g);
 int bot_choose_move_medium(const Board* g);
-int pick_best_move(Board* g);
+/* The same with a private rand_r state (seed NULL = rand()), so
+ * concurrent games each follow their own reproducible sequence. */
+int bot_choose_move_r(const Board* g, unsigned* seed);
+int bot_choose_move_medium_r(const Board* g, unsigned* seed);
+/* Search budget for the hard bot. Zero fields mean "no limit" (or the
+ * default depth for max_depth). Iterative deepening stops at whichever limit
+ * is hit first and plays the best move of the last completed iteration. */
+typedef struct {
+	int max_depth;
+	int time_ms;
+	unsigned long long max_nodes;
+	int eval;            /* BOT_EVAL_* used at the depth limit */
+	const int* stop;     /* "move now" request: the search plays its best move so
+	                        far once *stop != 0; it never writes the flag.
+	                        NULL = run to the budget */
+} BotLimits;
+
+/* Leaf evaluation variants: bitboard threat evaluation (default) and the
+ * original per-cell window scan, kept for comparison. */
+enum { BOT_EVAL_BITBOARD = 0, BOT_EVAL_WINDOWS = 1 };
+
+/* Static evaluation of g from side's point of view. */
+int bot_evaluate(const Board* g, char side, int variant);
+
+/* Statistics of one search, summed over its threads. */
+typedef struct {
+	unsigned long long nodes;
+	unsigned long long tt_probes;
+	unsigned long long tt_hits;        /* probes that returned a usable value */
+	unsigned long long tt_stores;
+	unsigned long long cutoffs;        /* beta cutoffs */
+	unsigned long long first_cutoffs;  /* ... on the first move searched */
+	double first_cutoff_rate;          /* first_cutoffs / cutoffs */
+	double ebf;                        /* effective branching factor */
+	int depth;                         /* deepest completed iteration */
+	int threads;
+	int book;                          /* move came from the opening book */
+	int ponder;                        /* ... from a ponder hit (see ponder.h) */
+	long long elapsed_ns;
+} BotStats;
+
+/* Hard bot move for g. stats may be NULL. */
+int pick_best_move(Board* g, const BotLimits* limits, BotStats* stats);
+/* Best move for g recorded in the transposition table, or -1. */
+int bot_tt_move(const Board* g);
+/* Lazy SMP thread count for pick_best_move (0 = one per core). */
+void bot_set_threads(int n);
+int bot_get_threads(void);
+/* Share TT entries between mirror-image positions (on by default). */
+void bot_set_symmetry(int on);
+/* Offline solver. WEAK decides win (1) / draw (0) / loss (-1) for the side
+ * to move; STRONG finds the exact score: (43 - p) / 2 for a win whose
+ * winning stone is played with p stones on the board, negative for a loss,
+ * 0 for a draw. best_move is a 0-based column reaching the score. */
+typedef enum { SOLVE_WEAK, SOLVE_STRONG } SolveMode;
+
+typedef struct {
+	int score;
+	int best_move;
+	BotStats stats;      /* depth is the number of squares left */
+} SolveResult;
+
+int solve_position(Board* g, SolveMode mode, SolveResult* out);
+const char* solve_str(Board* g);
+
+/* One JSON line describing a search ("hard", "solve", ...) that chose move. */
+void bot_stats_print_json(FILE* out, const char* search, int move, const BotStats* s);
 void zobrist_init();
-void tt_init();
 void shutdown_bot();
 
 #endif
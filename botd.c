@@ -0,0 +1,894 @@
+// Hard-bot move server.
+//
+//   ./connect4-botd [-p port] [-j workers] [-t ms]
+//   ./connect4-botd --query MOVES [-h ip] [-p port] [-d depth] [-t ms]
+//   ./connect4-botd --bench queries [-c clients] [-j workers] [-d depth]
+//
+// Serves hard-bot moves from one warm process (default port 4445), so test
+// harnesses and other frontends need not start a search engine per game.
+// A client sends NET_QUERY frames (net.h): search depth, time budget in ms
+// and the 0-based columns played from the empty board, A first, with
+// net_state_hash() of the position in the header. Each query gets one
+// NET_REPLY carrying its sequence number, so a client may pipeline queries
+// and match replies that come back out of order. A budget of zero depth and
+// zero time means -t ms (default 100).
+//
+// The main thread multiplexes the listener and every client on epoll and
+// queues searches for a fixed pool of `workers` threads (default: one per
+// core). Each worker runs single-threaded searches against the one shared
+// transposition table and opening book. A query for a position and budget
+// that is already queued or being searched joins that search instead of
+// starting another; all its queries get the same reply.
+//
+// Every 10 s the daemon prints queries/s, queue depth, searches in flight,
+// coalesced queries and p50/p99 latency from arrival to reply. --query asks
+// a running daemon for one move (1-based MOVES as in connect4-solve).
+// --bench runs the daemon in-process with `clients` connections (default
+// 16), each sending queries back to back from a pool of random openings,
+// and reports throughput, latency and coalescing.
+
+#define _GNU_SOURCE
+#include "gamelogic.h"
+#include "bot.h"
+#include "book.h"
+#include "tt.h"
+#include "net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#define BOTD_PORT        4445
+#define BOTD_DEFAULT_MS  100
+#define BOTD_MAX_WORKERS 256
+#define BOTD_EVENTS      256
+#define BOTD_STATS_SEC   10
+#define BOTD_BUCKETS     4096    // in-flight table, power of two
+#define BOTD_SAMPLES     65536   // latency samples kept per report
+#define BOTD_REPLY_LEN   10
+
+enum { REPLY_OK = 0, REPLY_INVALID = 1 };
+enum { REPLY_COALESCED = 1, REPLY_BOOK = 2 };
+
+typedef struct Waiter Waiter;
+typedef struct Job    Job;
+
+// A query waiting for its search; its connection may be gone by then
+struct Waiter {
+	int      fd;
+	unsigned gen;
+	uint16_t seq;
+	int      joined;    // coalesced into a search started for another query
+	double   t0;
+	Waiter*  next;
+};
+
+// One search, shared by every query for the same position and budget.
+// Workers touch only board, budget, move and stats.
+struct Job {
+	Board    board;
+	uint32_t hash;
+	int      depth;
+	int      time_ms;
+	int      move;
+	BotStats stats;
+	Waiter*  waiters;
+	Job*     next_bucket;
+	Job*     next;        // work queue, then done list
+};
+
+typedef struct {
+	NetConn  net;
+	unsigned gen;
+	int      want_out;    // EPOLLOUT registered
+	int      dirty;       // on the dirty list
+} Conn;
+
+typedef struct {
+	int      listen_fd;
+	int      epfd;
+	int      notify[2];   // workers -> main loop: searches are done
+	int      default_ms;
+	int      verbose;
+
+	// Main thread only
+	Conn**   conns;       // by descriptor
+	long     max_fds;
+	unsigned next_gen;
+	int*     dirty;       // descriptors with replies queued in this batch
+	int      n_dirty;
+	Job*     buckets[BOTD_BUCKETS];
+
+	pthread_mutex_t lock; // guards the queue, the done list and stopping
+	pthread_cond_t  wake;
+	Job*      queue_head;
+	Job*      queue_tail;
+	Job*      done;
+	int       queued;
+	int       stopping;   // also the workers' "move now" flag
+	pthread_t workers[BOTD_MAX_WORKERS];
+	int       n_workers;
+
+	// Statistics, main thread only
+	long long queries, coalesced, invalid;
+	int       in_flight, max_queued;
+	double*   samples;    // microseconds from arrival to reply
+	int       n_samples;
+} Daemon;
+
+static double now_sec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static long raise_fd_limit(void) {
+	struct rlimit rl;
+	if (getrlimit(RLIMIT_NOFILE, &rl) != 0)
+		return 1024;
+	rl.rlim_cur = rl.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &rl);
+	getrlimit(RLIMIT_NOFILE, &rl);
+	return (long)rl.rlim_cur;
+}
+
+static int by_value(const void* a, const void* b) {
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+// p-th percentile of n samples, sorting them in place
+static double percentile(double* v, int n, double p) {
+	if (n == 0) return 0.0;
+	qsort(v, (size_t)n, sizeof(double), by_value);
+	int i = (int)(p * (n - 1) + 0.5);
+	return v[i];
+}
+
+// ---------------------------------------------------------------------------
+// Search workers
+// ---------------------------------------------------------------------------
+
+static void* worker_main(void* arg) {
+	Daemon* d = arg;
+	for (;;) {
+		pthread_mutex_lock(&d->lock);
+		while (!d->queue_head && !d->stopping)
+			pthread_cond_wait(&d->wake, &d->lock);
+		if (d->stopping) {
+			pthread_mutex_unlock(&d->lock);
+			return NULL;
+		}
+		Job* job = d->queue_head;
+		d->queue_head = job->next;
+		if (!d->queue_head)
+			d->queue_tail = NULL;
+		d->queued--;
+		pthread_mutex_unlock(&d->lock);
+
+		BotLimits limits = { job->depth, job->time_ms, 0, BOT_EVAL_BITBOARD, &d->stopping };
+		Board     b      = job->board;
+		job->move = pick_best_move(&b, &limits, &job->stats);
+
+		pthread_mutex_lock(&d->lock);
+		job->next = d->done;
+		d->done   = job;
+		pthread_mutex_unlock(&d->lock);
+
+		// A full pipe already has a wake-up pending
+		uint8_t one = 1;
+		if (write(d->notify[1], &one, 1) < 0 && errno != EAGAIN)
+			perror("notify");
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Connections (main thread)
+// ---------------------------------------------------------------------------
+
+static Conn* conn_get(Daemon* d, int fd, unsigned gen) {
+	Conn* c = (fd >= 0 && fd < d->max_fds) ? d->conns[fd] : NULL;
+	return (c && c->gen == gen) ? c : NULL;
+}
+
+static void conn_close(Daemon* d, int fd) {
+	Conn* c = d->conns[fd];
+	if (!c) return;
+	epoll_ctl(d->epfd, EPOLL_CTL_DEL, fd, NULL);
+	close(fd);
+	free(c);
+	d->conns[fd] = NULL;
+}
+
+static void conn_flush(Daemon* d, int fd) {
+	Conn* c = d->conns[fd];
+	if (!c) return;
+	int r = net_flush(&c->net);
+	if (r < 0) {
+		conn_close(d, fd);
+		return;
+	}
+	int want_out = (r == 0);
+	if (c->want_out != want_out) {
+		struct epoll_event ev;
+		ev.events  = EPOLLIN | EPOLLRDHUP | (want_out ? EPOLLOUT : 0);
+		ev.data.fd = fd;
+		epoll_ctl(d->epfd, EPOLL_CTL_MOD, fd, &ev);
+		c->want_out = want_out;
+	}
+}
+
+// Replies queued in one epoll batch go out in one write per connection.
+// A descriptor closed and reused meanwhile just gets an extra flush.
+static void flush_dirty(Daemon* d) {
+	for (int i = 0; i < d->n_dirty; i++) {
+		int fd = d->dirty[i];
+		if (d->conns[fd])
+			d->conns[fd]->dirty = 0;
+		conn_flush(d, fd);
+	}
+	d->n_dirty = 0;
+}
+
+static void reply(Daemon* d, int fd, unsigned gen, uint16_t seq, uint32_t hash,
+                  int status, int move, int depth, int flags, double t0) {
+	Conn* c = conn_get(d, fd, gen);
+	if (!c) return;
+
+	uint32_t us = (uint32_t)((now_sec() - t0) * 1e6);
+	uint8_t  p[BOTD_REPLY_LEN] = {
+		(uint8_t)(seq >> 8), (uint8_t)seq, (uint8_t)status, (uint8_t)move,
+		(uint8_t)depth, (uint8_t)flags,
+		(uint8_t)(us >> 24), (uint8_t)(us >> 16), (uint8_t)(us >> 8), (uint8_t)us
+	};
+	// Make room once; a client that still doesn't read is dropped
+	if (net_queue(&c->net, NET_REPLY, hash, p, sizeof p) != 0 &&
+	    (net_flush(&c->net) < 0 || net_queue(&c->net, NET_REPLY, hash, p, sizeof p) != 0)) {
+		conn_close(d, fd);
+		return;
+	}
+	if (status == REPLY_OK && d->n_samples < BOTD_SAMPLES)
+		d->samples[d->n_samples++] = us;
+	if (c->dirty)
+		return;
+	if (d->n_dirty < d->max_fds) {
+		c->dirty = 1;
+		d->dirty[d->n_dirty++] = fd;
+	} else {
+		conn_flush(d, fd);
+	}
+}
+
+static void accept_all(Daemon* d) {
+	for (;;) {
+		int fd = accept4(d->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				perror("accept");
+			return;
+		}
+		Conn* c = (fd < d->max_fds) ? calloc(1, sizeof(Conn)) : NULL;
+		struct epoll_event ev;
+		ev.events  = EPOLLIN | EPOLLRDHUP;
+		ev.data.fd = fd;
+		if (!c || epoll_ctl(d->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+			free(c);
+			close(fd);
+			continue;
+		}
+		net_conn_init(&c->net, fd);
+		c->gen       = ++d->next_gen;
+		d->conns[fd] = c;
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Queries (main thread)
+// ---------------------------------------------------------------------------
+
+static unsigned job_bucket(const Board* b, int depth, int time_ms) {
+	uint64_t h = b->playerA * 0x9E3779B97F4A7C15ULL ^ b->playerB * 0xC2B2AE3D27D4EB4FULL ^
+	             (uint64_t)depth << 16 ^ (uint64_t)time_ms;
+	return (unsigned)(h >> 40) & (BOTD_BUCKETS - 1);
+}
+
+static Job* job_find(Daemon* d, const Board* b, int depth, int time_ms) {
+	for (Job* j = d->buckets[job_bucket(b, depth, time_ms)]; j; j = j->next_bucket) {
+		if (j->board.playerA == b->playerA && j->board.playerB == b->playerB &&
+		    j->depth == depth && j->time_ms == time_ms)
+			return j;
+	}
+	return NULL;
+}
+
+static void job_unlink(Daemon* d, Job* job) {
+	Job** p = &d->buckets[job_bucket(&job->board, job->depth, job->time_ms)];
+	while (*p != job)
+		p = &(*p)->next_bucket;
+	*p = job->next_bucket;
+}
+
+// Replays a query into *b: 0 if it is malformed or illegal, if the game is
+// already over, or if the position does not match the header hash
+static int parse_query(const NetFrame* f, Board* b, int* depth, int* time_ms) {
+	if (f->len < 3)
+		return 0;
+	*depth   = f->payload[0];
+	*time_ms = f->payload[1] << 8 | f->payload[2];
+
+	initializeBoard(b, 'A');
+	for (int i = 3; i < f->len; i++) {
+		char side = b->current;
+		if (f->payload[i] >= COLS || game_drop(b, f->payload[i], side) == -1 ||
+		    checkWin(b, side))
+			return 0;
+		b->current = (side == 'A') ? 'B' : 'A';
+	}
+	return !checkDraw(b) && f->hash == net_state_hash(b);
+}
+
+// Starts a search for the query or joins the one in flight; 0 on a frame
+// that is not a query or when out of memory
+static int handle_query(Daemon* d, int fd, const NetFrame* f) {
+	if (f->type != NET_QUERY)
+		return 0;
+
+	Conn*  c  = d->conns[fd];
+	double t0 = now_sec();
+	Board  b;
+	int    depth, time_ms;
+	d->queries++;
+
+	if (!parse_query(f, &b, &depth, &time_ms)) {
+		d->invalid++;
+		reply(d, fd, c->gen, f->seq, f->hash, REPLY_INVALID, 0, 0, 0, t0);
+		return 1;
+	}
+	if (!depth && !time_ms)
+		time_ms = d->default_ms;
+
+	Waiter* w = malloc(sizeof(Waiter));
+	if (!w)
+		return 0;
+	w->fd  = fd;
+	w->gen = c->gen;
+	w->seq = f->seq;
+	w->t0  = t0;
+
+	Job* job = job_find(d, &b, depth, time_ms);
+	if (job) {
+		w->joined    = 1;
+		w->next      = job->waiters;
+		job->waiters = w;
+		d->coalesced++;
+		return 1;
+	}
+
+	job = calloc(1, sizeof(Job));
+	if (!job) {
+		free(w);
+		return 0;
+	}
+	w->joined    = 0;
+	w->next      = NULL;
+	job->board   = b;
+	job->hash    = f->hash;
+	job->depth   = depth;
+	job->time_ms = time_ms;
+	job->waiters = w;
+
+	unsigned k = job_bucket(&b, depth, time_ms);
+	job->next_bucket = d->buckets[k];
+	d->buckets[k]    = job;
+	d->in_flight++;
+
+	pthread_mutex_lock(&d->lock);
+	if (d->queue_tail)
+		d->queue_tail->next = job;
+	else
+		d->queue_head = job;
+	d->queue_tail = job;
+	if (++d->queued > d->max_queued)
+		d->max_queued = d->queued;
+	pthread_cond_signal(&d->wake);
+	pthread_mutex_unlock(&d->lock);
+	return 1;
+}
+
+// Answers every query waiting on the searches the workers finished
+static void finish_jobs(Daemon* d) {
+	uint8_t buf[256];
+	while (read(d->notify[0], buf, sizeof buf) > 0)
+		;
+
+	pthread_mutex_lock(&d->lock);
+	Job* done = d->done;
+	d->done   = NULL;
+	pthread_mutex_unlock(&d->lock);
+
+	while (done) {
+		Job* job = done;
+		done     = job->next;
+		job_unlink(d, job);
+		d->in_flight--;
+
+		while (job->waiters) {
+			Waiter* w    = job->waiters;
+			int     ok   = job->move >= 0;
+			int     flags = (w->joined ? REPLY_COALESCED : 0) | (job->stats.book ? REPLY_BOOK : 0);
+			job->waiters = w->next;
+			reply(d, w->fd, w->gen, w->seq, job->hash, ok ? REPLY_OK : REPLY_INVALID,
+			      ok ? job->move : 0, job->stats.depth, flags, w->t0);
+			free(w);
+		}
+		free(job);
+	}
+}
+
+// One read, then every complete query in the buffer
+static void conn_event(Daemon* d, int fd, uint32_t events) {
+	Conn* c = d->conns[fd];
+	if (!c)
+		return;
+	if (events & EPOLLOUT) {
+		conn_flush(d, fd);
+		if (!d->conns[fd])
+			return;
+	}
+	if (!(events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+		return;
+
+	int n = net_fill(&c->net);
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return;
+	if (n <= 0) {
+		conn_close(d, fd);
+		return;
+	}
+
+	// A reply that finds the output full may close the connection
+	NetFrame f;
+	int      r = 0;
+	while (d->conns[fd] == c && (r = net_next_frame(&c->net, &f)) == 1) {
+		if (!handle_query(d, fd, &f)) {
+			conn_close(d, fd);
+			return;
+		}
+	}
+	if (r < 0)
+		conn_close(d, fd);
+}
+
+// ---------------------------------------------------------------------------
+// Daemon
+// ---------------------------------------------------------------------------
+
+static void print_stats(Daemon* d, long long queries, double seconds) {
+	pthread_mutex_lock(&d->lock);
+	int queued = d->queued;
+	pthread_mutex_unlock(&d->lock);
+
+	double p50 = percentile(d->samples, d->n_samples, 0.50);
+	double p99 = percentile(d->samples, d->n_samples, 0.99);
+	fprintf(stderr, "botd: %.0f queries/s, queue %d (max %d), %d searching, "
+		"%lld coalesced, %lld invalid, p50 %.1f ms, p99 %.1f ms\n",
+		seconds > 0 ? queries / seconds : 0.0, queued, d->max_queued,
+		d->in_flight - queued, d->coalesced, d->invalid, p50 / 1e3, p99 / 1e3);
+	d->n_samples  = 0;
+	d->max_queued = queued;
+}
+
+// Runs until *stop is set (checked at least once a second)
+static void botd_run(Daemon* d, const volatile int* stop) {
+	struct epoll_event events[BOTD_EVENTS];
+	double    last     = now_sec();
+	long long last_qry = 0;
+
+	while (!*stop) {
+		int n = epoll_wait(d->epfd, events, BOTD_EVENTS, 1000);
+		for (int i = 0; i < n; i++) {
+			int fd = events[i].data.fd;
+			if (fd == d->listen_fd)
+				accept_all(d);
+			else if (fd == d->notify[0])
+				finish_jobs(d);
+			else
+				conn_event(d, fd, events[i].events);
+		}
+		flush_dirty(d);
+
+		double now = now_sec();
+		if (d->verbose && now - last >= BOTD_STATS_SEC) {
+			print_stats(d, d->queries - last_qry, now - last);
+			last     = now;
+			last_qry = d->queries;
+		}
+	}
+}
+
+static int botd_start(Daemon* d, int port, int n_workers, int default_ms) {
+	memset(d, 0, sizeof *d);
+	d->default_ms = default_ms;
+	d->n_workers  = n_workers;
+	d->max_fds    = raise_fd_limit();
+	d->conns      = calloc((size_t)d->max_fds, sizeof(Conn*));
+	d->dirty      = malloc((size_t)d->max_fds * sizeof(int));
+	d->samples    = malloc(BOTD_SAMPLES * sizeof(double));
+	if (!d->conns || !d->dirty || !d->samples)
+		return 0;
+	pthread_mutex_init(&d->lock, NULL);
+	pthread_cond_init(&d->wake, NULL);
+
+	d->listen_fd = net_listen(port, SOMAXCONN);
+	if (d->listen_fd < 0 || net_set_nonblocking(d->listen_fd) != 0)
+		return 0;
+	if (pipe(d->notify) != 0 || net_set_nonblocking(d->notify[0]) != 0 ||
+	    net_set_nonblocking(d->notify[1]) != 0)
+		return 0;
+
+	d->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (d->epfd < 0)
+		return 0;
+	int fds[2] = { d->listen_fd, d->notify[0] };
+	for (int i = 0; i < 2; i++) {
+		struct epoll_event ev;
+		ev.events  = EPOLLIN;
+		ev.data.fd = fds[i];
+		if (epoll_ctl(d->epfd, EPOLL_CTL_ADD, fds[i], &ev) != 0)
+			return 0;
+	}
+
+	// The pool is the parallelism: every search stays single-threaded
+	bot_set_threads(1);
+	for (int i = 0; i < n_workers; i++) {
+		if (pthread_create(&d->workers[i], NULL, worker_main, d) != 0) {
+			perror("worker");
+			d->n_workers = i;
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// Stops the workers (searches in progress return early) and drops every
+// connection and unanswered query
+static void botd_stop(Daemon* d) {
+	pthread_mutex_lock(&d->lock);
+	__atomic_store_n(&d->stopping, 1, __ATOMIC_RELAXED);
+	pthread_cond_broadcast(&d->wake);
+	pthread_mutex_unlock(&d->lock);
+	for (int i = 0; i < d->n_workers; i++)
+		pthread_join(d->workers[i], NULL);
+
+	for (int k = 0; k < BOTD_BUCKETS; k++) {
+		while (d->buckets[k]) {
+			Job* job = d->buckets[k];
+			d->buckets[k] = job->next_bucket;
+			while (job->waiters) {
+				Waiter* w    = job->waiters;
+				job->waiters = w->next;
+				free(w);
+			}
+			free(job);
+		}
+	}
+	for (long fd = 0; fd < d->max_fds; fd++)
+		conn_close(d, (int)fd);
+
+	close(d->listen_fd);
+	close(d->notify[0]);
+	close(d->notify[1]);
+	close(d->epfd);
+	pthread_mutex_destroy(&d->lock);
+	pthread_cond_destroy(&d->wake);
+	free(d->conns);
+	free(d->dirty);
+	free(d->samples);
+}
+
+// ---------------------------------------------------------------------------
+// Clients: --query and --bench
+// ---------------------------------------------------------------------------
+
+// Query frame for the 0-based columns in cols; returns the payload length
+static int make_query(uint8_t* payload, int depth, int time_ms, const uint8_t* cols, int n) {
+	payload[0] = (uint8_t)depth;
+	payload[1] = (uint8_t)(time_ms >> 8);
+	payload[2] = (uint8_t)time_ms;
+	memcpy(payload + 3, cols, (size_t)n);
+	return 3 + n;
+}
+
+static uint32_t reply_us(const NetFrame* f) {
+	return (uint32_t)f->payload[6] << 24 | (uint32_t)f->payload[7] << 16 |
+	       (uint32_t)f->payload[8] << 8 | f->payload[9];
+}
+
+static int run_query(const char* ip, int port, const char* moves, int depth, int time_ms) {
+	Board   b;
+	uint8_t cols[ROWS * COLS];
+	int     n = (int)strlen(moves);
+	initializeBoard(&b, 'A');
+	if (n > ROWS * COLS || game_play_moves(&b, moves) < 0) {
+		fprintf(stderr, "botd: invalid moves \"%s\"\n", moves);
+		return 2;
+	}
+	for (int i = 0; i < n; i++)
+		cols[i] = (uint8_t)(moves[i] - '1');
+
+	int fd = net_open_client(ip, port);
+	if (fd < 0)
+		return 1;
+
+	NetConn  c;
+	NetFrame f;
+	uint8_t  payload[NET_MAX_PAYLOAD];
+	net_conn_init(&c, fd);
+	int len = make_query(payload, depth, time_ms, cols, n);
+	if (net_send(&c, NET_QUERY, net_state_hash(&b), payload, len) != 0 ||
+	    net_recv(&c, &f) != 1 || f.type != NET_REPLY || f.len != BOTD_REPLY_LEN) {
+		fprintf(stderr, "botd: no reply\n");
+		close(fd);
+		return 1;
+	}
+	close(fd);
+
+	if (f.payload[2] != REPLY_OK) {
+		printf("%s invalid\n", moves);
+		return 1;
+	}
+	// <moves> <best column> <depth> <microseconds> [book]
+	printf("%s %d %d %u%s\n", moves, f.payload[3] + 1, f.payload[4], reply_us(&f),
+		(f.payload[5] & REPLY_BOOK) ? " book" : "");
+	return 0;
+}
+
+#define BENCH_POOL 64
+
+typedef struct {
+	uint8_t  cols[16];
+	int      n;
+	uint32_t hash;
+} BenchPos;
+
+typedef struct {
+	struct sockaddr_in addr;
+	const BenchPos*    pool;
+	int                depth;
+	int                queries;
+	unsigned           seed;
+	double*            latency;   // seconds, one per query
+	int                failed;
+	pthread_t          thread;
+} BenchClient;
+
+// Random opening of 4 to 10 moves in which nobody has won yet
+static void bench_position(BenchPos* p, unsigned* seed) {
+	for (;;) {
+		Board b;
+		int   ok = 1;
+		initializeBoard(&b, 'A');
+		p->n = 4 + (int)(rand_r(seed) % 7);
+		for (int i = 0; i < p->n && ok; ) {
+			int  c    = (int)(rand_r(seed) % COLS);
+			char side = b.current;
+			if (game_drop(&b, c, side) == -1)
+				continue;
+			p->cols[i++] = (uint8_t)c;
+			ok           = !checkWin(&b, side);
+			b.current    = (side == 'A') ? 'B' : 'A';
+		}
+		if (ok) {
+			p->hash = net_state_hash(&b);
+			return;
+		}
+	}
+}
+
+// Queries back to back, one outstanding at a time
+static void* bench_client(void* arg) {
+	BenchClient* bc = arg;
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr*)&bc->addr, sizeof bc->addr) != 0) {
+		bc->failed = bc->queries;
+		if (fd >= 0) close(fd);
+		return NULL;
+	}
+
+	NetConn c;
+	net_conn_init(&c, fd);
+	for (int i = 0; i < bc->queries; i++) {
+		const BenchPos* p = &bc->pool[rand_r(&bc->seed) % BENCH_POOL];
+		uint8_t  payload[NET_MAX_PAYLOAD];
+		NetFrame f;
+		int      len = make_query(payload, bc->depth, 0, p->cols, p->n);
+		double   t0  = now_sec();
+		if (net_send(&c, NET_QUERY, p->hash, payload, len) != 0 ||
+		    net_recv(&c, &f) != 1 || f.type != NET_REPLY || f.len != BOTD_REPLY_LEN ||
+		    f.payload[2] != REPLY_OK) {
+			bc->failed += bc->queries - i;
+			break;
+		}
+		bc->latency[i] = now_sec() - t0;
+	}
+	close(fd);
+	return NULL;
+}
+
+typedef struct {
+	Daemon*      d;
+	volatile int stop;
+} DaemonThread;
+
+static void* daemon_thread_main(void* arg) {
+	DaemonThread* t = arg;
+	botd_run(t->d, &t->stop);
+	return NULL;
+}
+
+static int run_bench(int queries, int n_clients, int n_workers, int depth) {
+	if (n_clients > queries)
+		n_clients = queries;
+
+	tt_open(NULL);
+	Daemon* d = malloc(sizeof(Daemon));
+	if (!d || !botd_start(d, 0, n_workers, BOTD_DEFAULT_MS)) {
+		fprintf(stderr, "botd: cannot start\n");
+		return 1;
+	}
+
+	struct sockaddr_in addr;
+	socklen_t len = sizeof addr;
+	getsockname(d->listen_fd, (struct sockaddr*)&addr, &len);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	BenchPos pool[BENCH_POOL];
+	unsigned seed = 1;
+	for (int i = 0; i < BENCH_POOL; i++)
+		bench_position(&pool[i], &seed);
+
+	DaemonThread dt = { d, 0 };
+	pthread_t    thread;
+	pthread_create(&thread, NULL, daemon_thread_main, &dt);
+
+	BenchClient* clients = calloc((size_t)n_clients, sizeof(BenchClient));
+	double*      latency = calloc((size_t)queries, sizeof(double));
+	if (!clients || !latency) {
+		fprintf(stderr, "botd: out of memory\n");
+		return 1;
+	}
+
+	double t0 = now_sec();
+	for (int i = 0, first = 0; i < n_clients; i++) {
+		BenchClient* bc = &clients[i];
+		bc->addr    = addr;
+		bc->pool    = pool;
+		bc->depth   = depth;
+		bc->queries = queries / n_clients + (i < queries % n_clients);
+		bc->seed    = (unsigned)i + 1;
+		bc->latency = latency + first;
+		first      += bc->queries;
+		pthread_create(&bc->thread, NULL, bench_client, bc);
+	}
+	int failed = 0;
+	for (int i = 0; i < n_clients; i++) {
+		pthread_join(clients[i].thread, NULL);
+		failed += clients[i].failed;
+	}
+	double elapsed = now_sec() - t0;
+
+	dt.stop = 1;
+	pthread_join(thread, NULL);
+
+	int answered = queries - failed;
+	printf("Bot daemon bench: %d queries, %d clients, %d workers, depth %d\n",
+		queries, n_clients, n_workers, depth);
+	printf("  throughput : %8.0f queries/s  (%d in %.3f s)\n",
+		answered / elapsed, answered, elapsed);
+	printf("  latency    : p50 %.2f ms, p99 %.2f ms (client side)\n",
+		percentile(latency, queries, 0.50) * 1e3, percentile(latency, queries, 0.99) * 1e3);
+	printf("  coalesced  : %lld queries joined a search in flight (%.1f%%)\n",
+		d->coalesced, d->queries ? 100.0 * d->coalesced / d->queries : 0.0);
+	printf("  queue depth: %d at most\n", d->max_queued);
+	if (failed)
+		printf("  %d queries failed\n", failed);
+
+	botd_stop(d);
+	free(d);
+	free(clients);
+	free(latency);
+	tt_free();
+	return failed ? 1 : 0;
+}
+
+// ---------------------------------------------------------------------------
+
+static volatile int stop_requested = 0;
+
+static void on_signal(int sig) {
+	(void)sig;
+	stop_requested = 1;
+}
+
+static void usage(const char* prog) {
+	fprintf(stderr, "usage: %s [-p port] [-j workers] [-t ms]\n", prog);
+	fprintf(stderr, "       %s --query MOVES [-h ip] [-p port] [-d depth] [-t ms]\n", prog);
+	fprintf(stderr, "       %s --bench queries [-c clients] [-j workers] [-d depth]\n", prog);
+}
+
+int main(int argc, char** argv) {
+	int         port    = BOTD_PORT;
+	int         workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	int         time_ms = -1;
+	int         depth   = 0;
+	int         clients = 16;
+	int         bench   = 0;
+	const char* ip      = "127.0.0.1";
+	const char* query   = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			port = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			workers = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			time_ms = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+			depth = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+			clients = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+			ip = argv[++i];
+		} else if (strcmp(argv[i], "--query") == 0 && i + 1 < argc) {
+			query = argv[++i];
+		} else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+			bench = atoi(argv[++i]);
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if (workers < 1 || workers > BOTD_MAX_WORKERS || port < 0 || port > 65535 ||
+	    time_ms > 65535 || depth < 0 || depth > 255 || clients < 1 || bench < 0) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+	zobrist_init();
+	if (query)
+		return run_query(ip, port, query, depth, time_ms < 0 ? 0 : time_ms);
+	if (bench)
+		return run_bench(bench, clients, workers, depth ? depth : 10);
+
+	tt_init();
+	book_init();
+	Daemon* d = malloc(sizeof(Daemon));
+	if (!d || !botd_start(d, port, workers, time_ms < 0 ? BOTD_DEFAULT_MS : time_ms)) {
+		perror("botd");
+		return 1;
+	}
+	d->verbose = 1;
+	fprintf(stderr, "botd: listening on port %d with %d search workers\n", port, workers);
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+	botd_run(d, &stop_requested);
+	botd_stop(d);
+	free(d);
+	tt_flush();
+	shutdown_bot();
+	return 0;
+}
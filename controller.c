@@ -3,14 +3,23 @@
 #include "gamelogic.h"
 #include "ui.h"
 #include "bot.h"
+#include "tt.h"
+#include "book.h"
+#include "ponder.h"
 #include "history.h"
 #include "input.h"
+#include "event.h"
 #include "net.h"
+#include "spectate.h"
+#include "record.h"
 
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
+#include <pthread.h>
 #include <arpa/inet.h>
 
 static const char *quick_chat_msgs[] = {
@@ -30,8 +39,149 @@ static void print_quick_chat(char player, int idx) {
 	printf("[Player %c] %s\n", player, quick_chat_msgs[idx]);
 }
 
+// Shows the quick chat menu and returns the chosen message, or -1
+static int choose_quick_chat(void) {
+	printf("Quick chat:\n");
+	for (int i = 0; i < QUICK_CHAT_COUNT; i++) {
+		printf(" %d) %s\n", i + 1, quick_chat_msgs[i]);
+	}
+	printf("Choose 1-%d (or 0 to cancel): ", QUICK_CHAT_COUNT);
+	fflush(stdout);
+	char buf[16];
+	if (read_line(buf, sizeof buf)) {
+		int choice = atoi(buf);
+		if (choice >= 1 && choice <= QUICK_CHAT_COUNT)
+			return choice - 1;
+	}
+	return -1;
+}
+
+static int is_chat_command(const char *line) {
+	while (*line == ' ' || *line == '\t')
+		line++;
+	return *line == 't' || *line == 'T';
+}
+
 static int g_allow_chat = 0;
 
+// --stats: one JSON line per hard-bot search, NULL = off
+static FILE* g_stats_out = NULL;
+
+void controller_set_stats(FILE* out) {
+	g_stats_out = out;
+}
+
+// Finished games are appended here (record.h), NULL = off. Interactive
+// games open the file per game; a headless run keeps it open in
+// g_record_out and streams every game into it.
+static const char* g_record_path = RECORD_FILE;
+static FILE*       g_record_out  = NULL;
+
+void controller_set_record(const char* path) {
+	g_record_path = path;
+}
+
+// Appends the game on the board to the record file: the moves up to the
+// current one, so undone moves are left out. players as in GameRecord,
+// hard the search budget of the side(s) played by the hard bot, resigned
+// the letter of the player who resigned or 0.
+static void record_game(const Board* G, const History* H, char start, int players,
+                        const BotLimits* hard, char resigned) {
+	if (!g_record_path)
+		return;
+
+	GameRecord r;
+	record_init(&r, start, players);
+	for (int i = 0; i < H->current_index; i++)
+		record_push(&r, H->moves[i].col);
+	if (resigned)
+		r.result = (uint8_t)((resigned == 'A' ? RECORD_WIN_B : RECORD_WIN_A) | RECORD_RESIGNED);
+	else
+		r.result = (uint8_t)record_outcome(G);
+	for (int side = 0; side < 2 && hard; side++) {
+		if (((players >> (4 * side)) & 15) != RECORD_HARD)
+			continue;
+		r.depth[side]   = (uint8_t)hard->max_depth;
+		r.eval[side]    = (uint8_t)hard->eval;
+		r.time_ms[side] = (uint16_t)hard->time_ms;
+	}
+	r.finished = (uint32_t)time(NULL);
+
+	int err = g_record_out ? record_write(g_record_out, &r) : record_save(g_record_path, &r);
+	if (err != 0)
+		fprintf(stderr, "Could not save the game to %s.\n", g_record_path);
+}
+
+// Hard bot search budget per difficulty (indexed by the bot menu choice).
+// Easy and medium don't search; iterative deepening stops the hard bot at
+// its time limit even if the depth isn't reached.
+static const BotLimits bot_limits[] = {
+	[3] = { .max_depth = 42, .time_ms = 1000, .max_nodes = 0 },
+};
+
+// The hard bot searches on a worker thread that wakes the event loop when
+// it is done, so the keyboard stays live while it thinks: 'm' makes it move
+// now with its best move so far, 'q' stops the search and quits.
+typedef struct {
+	Board     board;
+	BotLimits limits;
+	BotStats  stats;
+	int       want_stats;
+	int       cancel;
+	int       move;
+	int       done;
+} BotJob;
+
+static void* bot_job_main(void* arg) {
+	BotJob* job = arg;
+	job->move = ponder_pick_move(&job->board, &job->limits,
+	                             job->want_stats ? &job->stats : NULL);
+	__atomic_store_n(&job->done, 1, __ATOMIC_RELEASE);
+	event_notify();
+	return NULL;
+}
+
+// Returns the bot's column, or -2 if the player quit while it was thinking
+static int bot_think(Board* G, const BotLimits* limits, BotStats* stats) {
+	BotJob job;
+	memset(&job, 0, sizeof job);
+	job.board       = *G;
+	job.limits      = *limits;
+	job.limits.stop = &job.cancel;
+	job.want_stats  = stats != NULL;
+
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, bot_job_main, &job) != 0)
+		return ponder_pick_move(G, limits, stats);
+
+	int quit = 0;
+	while (!__atomic_load_n(&job.done, __ATOMIC_ACQUIRE)) {
+		if (!input_has_line()) {
+			event_run_once(-1);
+			continue;
+		}
+		char line[128];
+		int  col0;
+		read_line(line, sizeof line);
+		const char* s = line;
+		while (isspace((unsigned char)*s))
+			s++;
+		if (*s == 'm' || *s == 'M') {
+			__atomic_store_n(&job.cancel, 1, __ATOMIC_RELAXED);
+		} else if (parse_action(line, &col0) == -1) {
+			quit = 1;
+			__atomic_store_n(&job.cancel, 1, __ATOMIC_RELAXED);
+		} else {
+			puts("The bot is thinking... ('m' to move now, 'q' to quit)");
+		}
+	}
+	pthread_join(thread, NULL);
+
+	if (stats)
+		*stats = job.stats;
+	return quit ? -2 : job.move;
+}
+
 static void switch_player(Board* G) {
 	if (G->current == 'A')
 		G->current = 'B';
@@ -50,7 +200,24 @@ static int do_drop(Board* G, int col0, int use_anim, int anim_ms) {
 	}
 }
 
-static int handle_turn(Board* G, int undo_span, int use_anim, int anim_ms) {
+// Drops col0 for G->current and records it in H. Returns -1 if the column
+// is full, 1 if the move won, 2 if it filled the board, and otherwise 0
+// with the other player to move.
+static int play_move(Board* G, History* H, int col0, int use_anim, int anim_ms) {
+	int row = do_drop(G, col0, use_anim, anim_ms);
+	if (row == -1)
+		return -1;
+
+	history_record_move(H, row, col0, G->current);
+	if (checkWin(G, G->current))
+		return 1;
+	if (game_is_full(G))
+		return 2;
+	switch_player(G);
+	return 0;
+}
+
+static int handle_turn(Board* G, History* H, int undo_span, int use_anim, int anim_ms) {
 	char line[128];
 
 	for (;;) {
@@ -65,27 +232,11 @@ static int handle_turn(Board* G, int undo_span, int use_anim, int anim_ms) {
 		if (!read_line(line, sizeof line))
 			return -1;
 
-		if (g_allow_chat) {
-			const char *p = line;
-			while (*p == ' ' || *p == '\t')
-				p++;
-			if (*p == 't' || *p == 'T') {
-				printf("Quick chat:\n");
-				for (int i = 0; i < QUICK_CHAT_COUNT; i++) {
-					printf(" %d) %s\n", i + 1, quick_chat_msgs[i]);
-				}
-				printf("Choose 1-%d (or 0 to cancel): ", QUICK_CHAT_COUNT);
-				fflush(stdout);
-				char buf[16];
-				if (fgets(buf, sizeof buf, stdin)) {
-					int choice = atoi(buf);
-					if (choice >= 1 && choice <= QUICK_CHAT_COUNT) {
-						int idx = choice - 1;
-						print_quick_chat(G->current, idx);
-					}
-				}
-				continue;
-			}
+		if (g_allow_chat && is_chat_command(line)) {
+			int idx = choose_quick_chat();
+			if (idx >= 0)
+				print_quick_chat(G->current, idx);
+			continue;
 		}
 
 		int col0 = -1;
@@ -95,7 +246,7 @@ static int handle_turn(Board* G, int undo_span, int use_anim, int anim_ms) {
 			return -2;
 
 		if (a == -2) {
-			if (history_undo(G, undo_span))
+			if (history_undo(H, G, undo_span))
 				ui_print_board(G, 1);
 			else
 				puts("Nothing to undo.");
@@ -103,7 +254,7 @@ static int handle_turn(Board* G, int undo_span, int use_anim, int anim_ms) {
 		}
 
 		if (a == -3) {
-			if (history_redo(G, undo_span))
+			if (history_redo(H, G, undo_span))
 				ui_print_board(G, 1);
 			else
 				puts("Nothing to redo.");
@@ -115,27 +266,23 @@ static int handle_turn(Board* G, int undo_span, int use_anim, int anim_ms) {
 			continue;
 		}
 
-		int row = do_drop(G, col0, use_anim, anim_ms);
-		if (row == -1) {
+		int r = play_move(G, H, col0, use_anim, anim_ms);
+		if (r == -1) {
 			puts("Column is full. Choose another.");
 			return 0;
 		}
 
-		history_record_move(row, col0, G->current);
-
 		if (!use_anim)
 			ui_print_board(G, 1);
 
-		if (checkWin(G, G->current)) {
+		if (r == 1) {
 			printf("Player %c wins!\n", G->current);
 			return 1;
 		}
-		if (checkDraw(G)) {
+		if (r == 2) {
 			puts("It's a draw! Board is full.");
 			return 1;
 		}
-
-		switch_player(G);
 		return 0;
 	}
 }
@@ -145,7 +292,7 @@ static int play_again_prompt(void) {
 	while (1) {
 		printf("\nPlay again? (y/n): ");
 		fflush(stdout);
-		if (!fgets(choice, sizeof(choice), stdin))
+		if (!read_line(choice, sizeof(choice)))
 			return 0;
 		if (choice[0] == 'y' || choice[0] == 'Y')
 			return 1;
@@ -160,7 +307,7 @@ void run_human_vs_human(int use_anim, int anim_ms) {
 	g_allow_chat = 1;
 
 	printf("Which player goes first, A or B: ");
-	if (!fgets(turn, sizeof(turn), stdin)) {
+	if (!read_line(turn, sizeof(turn))) {
 		puts("\nInput ended. Exiting.");
 		exit(0);
 	}
@@ -168,7 +315,7 @@ void run_human_vs_human(int use_anim, int anim_ms) {
 	while (turn[0] != 'A' && turn[0] != 'B') {
 		puts("Invalid letter label, try again.");
 		printf("Which player goes first, A or B: ");
-		if (!fgets(turn, sizeof(turn), stdin)) {
+		if (!read_line(turn, sizeof(turn))) {
 			puts("\nInput ended. Exiting.");
 			exit(0);
 		}
@@ -177,13 +324,15 @@ void run_human_vs_human(int use_anim, int anim_ms) {
 	int keep_playing = 1;
 	while (keep_playing) {
 		Board G;
+		History H;
 		initializeBoard(&G, turn[0]);
-		history_reset();
+		history_reset(&H);
 		ui_print_board(&G, 1);
+		input_key_mode(1);
 
 		int game_over = 0;
 		while (!game_over) {
-			int r = handle_turn(&G, 1, use_anim, anim_ms);
+			int r = handle_turn(&G, &H, 1, use_anim, anim_ms);
 			if (r == -2) {
 				puts("Goodbye!");
 				exit(0);
@@ -195,6 +344,8 @@ void run_human_vs_human(int use_anim, int anim_ms) {
 			if (r == 1)
 				game_over = 1;
 		}
+		input_key_mode(0);
+		record_game(&G, &H, turn[0], RECORD_HUMAN | RECORD_HUMAN << 4, NULL, 0);
 
 		keep_playing = play_again_prompt();
 		if (!keep_playing) {
@@ -208,7 +359,7 @@ void run_vs_bot(int use_anim, int anim_ms, int difficulty) {
 	g_allow_chat = 0;
 
 	printf("Which player goes first, You(A) or the Bot(B): ");
-	if (!fgets(turn, sizeof(turn), stdin)) {
+	if (!read_line(turn, sizeof(turn))) {
 		puts("\nInput ended. Exiting.");
 		exit(0);
 	}
@@ -216,29 +367,34 @@ void run_vs_bot(int use_anim, int anim_ms, int difficulty) {
 	while (turn[0] != 'A' && turn[0] != 'B') {
 		puts("Invalid letter label, try again.");
 		printf("Which player goes first, You(A) or the Bot(B): ");
-		if (!fgets(turn, sizeof(turn), stdin)) {
+		if (!read_line(turn, sizeof(turn))) {
 			puts("\nInput ended. Exiting.");
 			exit(0);
 		}
 	}
 	zobrist_init();
 	tt_init();
+	book_init();
 	int play_more = 1;
 	while (play_more) {
 		Board G;
+		History H;
 		initializeBoard(&G, turn[0]);
-		history_reset();
+		history_reset(&H);
 		ui_print_board(&G, 1);
+		input_key_mode(1);
 		//char bot_side = (turn[0] == 'A') ? 'B' : 'A';
 		int game_over = 0;
 		while (!game_over) {
 			if (G.current == 'A') {
-				int r = handle_turn(&G, 2, use_anim, anim_ms);
+				int r = handle_turn(&G, &H, 2, use_anim, anim_ms);
 				if (r == -2) {
+					ponder_stop();
 					puts("Goodbye!");
 					exit(0);
 				}
 				if (r == -1) {
+					ponder_stop();
 					puts("\nInput ended. Exiting.");
 					exit(0);
 				}
@@ -252,11 +408,21 @@ void run_vs_bot(int use_anim, int anim_ms, int difficulty) {
 					col0 = bot_choose_move(&G);
 				else if (difficulty ==2)
 					col0 = bot_choose_move_medium(&G);
-				else
-					col0 = pick_best_move(&G);
+				else {
+					BotStats stats;
+					col0 = bot_think(&G, &bot_limits[difficulty],
+					                 g_stats_out ? &stats : NULL);
+					if (col0 == -2) {
+						ponder_stop();
+						puts("Goodbye!");
+						exit(0);
+					}
+					if (g_stats_out)
+						bot_stats_print_json(g_stats_out, "hard", col0, &stats);
+				}
 
 				if (col0 == -1) {
-					if (checkDraw(&G)) {
+					if (game_is_full(&G)) {
 						puts("It's a draw! Board is full.");
 						game_over = 1;
 						break;
@@ -264,7 +430,7 @@ void run_vs_bot(int use_anim, int anim_ms, int difficulty) {
 				} else {
 					int row = do_drop(&G, col0, use_anim, anim_ms);
 					if (row != -1) {
-						history_record_move(row, col0, G.current);
+						history_record_move(&H, row, col0, G.current);
 						if (!use_anim)
 							ui_print_board(&G, 1);
 
@@ -273,33 +439,149 @@ void run_vs_bot(int use_anim, int anim_ms, int difficulty) {
 							game_over = 1;
 							break;
 						}
-						if (checkDraw(&G)) {
+						if (game_is_full(&G)) {
 							puts("It's a draw! Board is full.");
 							game_over = 1;
 							break;
 						}
 						switch_player(&G);
+
+						// Keep the hard bot thinking while the human decides
+						if (difficulty == 3)
+							ponder_start(&G, &bot_limits[difficulty]);
 					}
 				}
 			}
 		}
-		shutdown_bot();
+		input_key_mode(0);
+		ponder_stop();
+		tt_flush();
+		if (difficulty == 3)
+			record_game(&G, &H, turn[0], RECORD_HUMAN | RECORD_HARD << 4, &bot_limits[3], 0);
+		else
+			record_game(&G, &H, turn[0],
+			            RECORD_HUMAN | (difficulty == 1 ? RECORD_RANDOM : RECORD_MEDIUM) << 4, NULL, 0);
 		play_more = play_again_prompt();
 		if (!play_more) {
 			puts("Thanks for playing!");
 		}
 	}
+	shutdown_bot();
 }
 
-static int net_send_action(int sockfd, unsigned char ch) {
-	if (net_send_byte(sockfd, ch) != 0) {
+// Frames from the peer arrive through the event loop whenever they are
+// sent. Chat is shown at once, even while the local player is typing;
+// every other frame queues in order for net_remote_turn.
+#define PEER_QUEUE 16
+
+typedef struct {
+	NetConn  conn;
+	NetFrame queue[PEER_QUEUE];
+	int      head;
+	int      len;
+	int      closed;
+	int      error;    // < 0: closed because of a bad frame (net_next_frame)
+	int      midway;   // spectating: take the sequence number of the first frame
+	char     player;   // the peer's letter, for chat lines
+	char     resigned; // letter of the player who resigned, 0 while nobody has
+} Peer;
+
+static Peer g_peer;
+
+// Mirrors an action of either player to the spectators when hosting;
+// chat and resignations name the player
+static void spectate_action(int type, int arg, char player) {
+	uint8_t payload[2] = { (uint8_t)arg, (uint8_t)player };
+	if (type == NET_RESIGN)
+		spectate_send(type, &payload[1], 1);
+	else
+		spectate_send(type, payload, type == NET_CHAT ? 2 : (arg < 0 ? 0 : 1));
+}
+
+static int net_send_action(const Board *G, int type, int arg) {
+	uint8_t payload = (uint8_t)arg;
+	if (net_send(&g_peer.conn, type, net_state_hash(G), &payload, arg < 0 ? 0 : 1) != 0) {
 		perror("Failed to send action to peer");
 		return -1;
 	}
+	spectate_action(type, arg, g_peer.player == 'A' ? 'B' : 'A');
 	return 0;
 }
 
-static int net_local_turn(Board *G, int use_anim, int anim_ms, int sockfd) {
+static int net_send_chat(const Board *G, char player) {
+	int idx = choose_quick_chat();
+	if (idx < 0)
+		return 0;
+	print_quick_chat(player, idx);
+	return net_send_action(G, NET_CHAT, idx);
+}
+
+static void peer_decode(Peer *q) {
+	NetFrame f;
+	int r;
+
+	while ((r = net_next_frame(&q->conn, &f)) == 1) {
+		if (f.type == NET_CHAT) {
+			// A spectator stream names the player after the message
+			char who = (f.len == 2) ? (char)f.payload[1] : q->player;
+			putchar('\n');
+			print_quick_chat(who, f.len >= 1 ? f.payload[0] : -1);
+			fflush(stdout);
+			if (f.len == 1)
+				spectate_action(NET_CHAT, f.payload[0], q->player);
+			continue;
+		}
+		if (q->len == PEER_QUEUE) {
+			// A well-behaved peer never gets this far ahead
+			r = -1;
+			break;
+		}
+		q->queue[(q->head + q->len++) % PEER_QUEUE] = f;
+	}
+	if (r < 0) {
+		q->closed = 1;
+		q->error = r;
+	}
+}
+
+static void on_peer_readable(int fd, void *ctx) {
+	Peer *q = ctx;
+	if (net_fill(&q->conn) <= 0)
+		q->closed = 1;
+	if (q->midway && net_sync_seq(&q->conn))
+		q->midway = 0;
+	peer_decode(q);   // including frames that came just before a hang-up
+	if (q->closed)
+		event_unwatch(fd);
+}
+
+static int peer_pop(Peer *q, NetFrame *out) {
+	if (q->len == 0)
+		return 0;
+	*out = q->queue[q->head];
+	q->head = (q->head + 1) % PEER_QUEUE;
+	q->len--;
+	return 1;
+}
+
+static void print_peer_error(int error) {
+	if (error == NET_ERR_VERSION)
+		puts("Opponent uses a different protocol version.");
+	else if (error < 0)
+		puts("Protocol error: malformed or out-of-order frame from opponent.");
+	else
+		puts("Connection closed by peer.");
+}
+
+// Both sides hash the board after each action: a mismatch means a desync
+static int peer_in_sync(const Board *G, const NetFrame *f) {
+	if (f->hash == net_state_hash(G))
+		return 1;
+	puts("Protocol error: board out of sync with the opponent.");
+	return 0;
+}
+
+static int net_local_turn(Board *G, History *H, int use_anim, int anim_ms) {
 	char line[128];
 
 	for (;;) {
@@ -309,32 +591,15 @@ static int net_local_turn(Board *G, int use_anim, int anim_ms, int sockfd) {
 
 		if (!read_line(line, sizeof line)) {
 			puts("\nInput ended. Resigning.");
-			if (net_send_action(sockfd, 'q') != 0)
+			g_peer.resigned = G->current;
+			if (net_send_action(G, NET_RESIGN, -1) != 0)
 				return -1;
 			return 1;
 		}
 
-		const char *p = line;
-		while (*p == ' ' || *p == '\t')
-			p++;
-		if (*p == 't' || *p == 'T') {
-			printf("Quick chat:\n");
-			for (int i = 0; i < QUICK_CHAT_COUNT; i++) {
-				printf(" %d) %s\n", i + 1, quick_chat_msgs[i]);
-			}
-			printf("Choose 1-%d (or 0 to cancel): ", QUICK_CHAT_COUNT);
-			fflush(stdout);
-			char buf[16];
-			if (fgets(buf, sizeof buf, stdin)) {
-				int choice = atoi(buf);
-				if (choice >= 1 && choice <= QUICK_CHAT_COUNT) {
-					int idx = choice - 1;
-					print_quick_chat(G->current, idx);
-					unsigned char code = (unsigned char)('c' + idx);
-					if (net_send_action(sockfd, code) != 0)
-						return -1;
-				}
-			}
+		if (is_chat_command(line)) {
+			if (net_send_chat(G, G->current) != 0)
+				return -1;
 			continue;
 		}
 
@@ -343,15 +608,16 @@ static int net_local_turn(Board *G, int use_anim, int anim_ms, int sockfd) {
 
 		if (a == -1) {
 			puts("You resigned. Game over.");
-			if (net_send_action(sockfd, 'q') != 0)
+			g_peer.resigned = G->current;
+			if (net_send_action(G, NET_RESIGN, -1) != 0)
 				return -1;
 			return 1;
 		}
 
 		if (a == -2) {
-			if (history_undo(G, 1)) {
+			if (history_undo(H, G, 1)) {
 				ui_print_board(G, 1);
-				if (net_send_action(sockfd, 'u') != 0)
+				if (net_send_action(G, NET_UNDO, -1) != 0)
 					return -1;
 				return 0;
 			} else {
@@ -361,9 +627,9 @@ static int net_local_turn(Board *G, int use_anim, int anim_ms, int sockfd) {
 		}
 
 		if (a == -3) {
-			if (history_redo(G, 1)) {
+			if (history_redo(H, G, 1)) {
 				ui_print_board(G, 1);
-				if (net_send_action(sockfd, 'r') != 0)
+				if (net_send_action(G, NET_REDO, -1) != 0)
 					return -1;
 				return 0;
 			} else {
@@ -384,11 +650,11 @@ static int net_local_turn(Board *G, int use_anim, int anim_ms, int sockfd) {
 				continue;
 			}
 
-			history_record_move(row, col0, G->current);
+			history_record_move(H, row, col0, G->current);
 			if (!use_anim)
 				ui_print_board(G, 1);
 
-			if (net_send_action(sockfd, (unsigned char)('1' + col0)) != 0)
+			if (net_send_action(G, NET_MOVE, col0) != 0)
 				return -1;
 
 			int win = checkWin(G, G->current);
@@ -397,7 +663,7 @@ static int net_local_turn(Board *G, int use_anim, int anim_ms, int sockfd) {
 				return 1;
 			}
 
-			if (checkDraw(G)) {
+			if (game_is_full(G)) {
 				puts("It's a draw! Board is full.");
 				return 1;
 			}
@@ -408,56 +674,83 @@ static int net_local_turn(Board *G, int use_anim, int anim_ms, int sockfd) {
 	}
 }
 
-static int net_remote_turn(Board *G, int use_anim, int anim_ms, int sockfd) {
-	unsigned char ch = 0;
-	puts("Waiting for opponent's move...");
+static int net_remote_turn(Board *G, History *H, int use_anim, int anim_ms) {
+	NetFrame f;
+	char my_player = (G->current == 'A') ? 'B' : 'A';
+	puts("Waiting for opponent's move... ('t' talk, 'q' resign)");
 	fflush(stdout);
 
-	if (net_recv_byte(sockfd, &ch) != 0) {
-		puts("Connection closed by peer.");
-		return -1;
+	// The keyboard stays live on the opponent's turn: chat and resigning
+	// don't have to wait for their move
+	while (!peer_pop(&g_peer, &f)) {
+		if (g_peer.closed) {
+			print_peer_error(g_peer.error);
+			return -1;
+		}
+		if (!input_has_line()) {
+			event_run_once(-1);
+			continue;
+		}
+
+		char line[128];
+		int col0;
+		read_line(line, sizeof line);
+		if (is_chat_command(line)) {
+			if (net_send_chat(G, my_player) != 0)
+				return -1;
+		} else if (parse_action(line, &col0) == -1) {
+			puts("You resigned. Game over.");
+			g_peer.resigned = my_player;
+			if (net_send_action(G, NET_RESIGN, -1) != 0)
+				return -1;
+			return 1;
+		} else {
+			puts("Wait for your opponent's move ('t' talk, 'q' resign).");
+		}
 	}
 
-	if (ch == 'q' || ch == 'Q') {
+	if (f.type == NET_RESIGN) {
 		puts("Opponent resigned. Game over.");
+		g_peer.resigned = g_peer.player;
+		spectate_action(NET_RESIGN, -1, g_peer.player);
 		return 1;
 	}
 
-	if (ch == 'u' || ch == 'U') {
-		if (history_undo(G, 1)) {
+	if (f.type == NET_UNDO) {
+		if (history_undo(H, G, 1)) {
 			ui_print_board(G, 1);
+			spectate_action(NET_UNDO, -1, g_peer.player);
 		} else {
 			puts("Opponent requested undo, but nothing to undo.");
 		}
-		return 0;
+		return peer_in_sync(G, &f) ? 0 : -1;
 	}
 
-	if (ch == 'r' || ch == 'R') {
-		if (history_redo(G, 1)) {
+	if (f.type == NET_REDO) {
+		if (history_redo(H, G, 1)) {
 			ui_print_board(G, 1);
+			spectate_action(NET_REDO, -1, g_peer.player);
 		} else {
 			puts("Opponent requested redo, but nothing to redo.");
 		}
-		return 0;
+		return peer_in_sync(G, &f) ? 0 : -1;
 	}
 
-	if (ch >= 'c' && ch < 'c' + QUICK_CHAT_COUNT) {
-		int idx = (int)(ch - 'c');
-		print_quick_chat(G->current, idx);
-		return 0;
-	}
-
-	if (ch >= '1' && ch <= '7') {
-		int col0 = (int)(ch - '1');
+	if (f.type == NET_MOVE && f.len == 1 && f.payload[0] < COLS) {
+		int col0 = f.payload[0];
 		int row = do_drop(G, col0, use_anim, anim_ms);
 		if (row == -1) {
 			printf("Protocol error: opponent tried to drop in full column %d.\n", col0 + 1);
 			return -1;
 		}
 
-		history_record_move(row, col0, G->current);
+		history_record_move(H, row, col0, G->current);
 		if (!use_anim)
 			ui_print_board(G, 1);
+		spectate_action(NET_MOVE, col0, g_peer.player);
+
+		if (!peer_in_sync(G, &f))
+			return -1;
 
 		int win = checkWin(G, G->current);
 		if (win) {
@@ -465,7 +758,7 @@ static int net_remote_turn(Board *G, int use_anim, int anim_ms, int sockfd) {
 			return 1;
 		}
 
-		if (checkDraw(G)) {
+		if (game_is_full(G)) {
 			puts("It's a draw! Board is full.");
 			return 1;
 		}
@@ -474,23 +767,43 @@ static int net_remote_turn(Board *G, int use_anim, int anim_ms, int sockfd) {
 		return 0;
 	}
 
-	printf("Received unknown action '%c' from opponent.\n", ch);
+	printf("Received unknown frame type %d from opponent.\n", f.type);
 	return -1;
 }
 
-static void run_network_game_loop(int sockfd, int is_server, int use_anim, int anim_ms, char start_player) {
+// watch_port: the host's spectator port, 0 for none
+static void run_network_game_loop(char my_player, int use_anim, int anim_ms, char start_player,
+                                  int watch_port) {
 	Board G;
+	History H;
 	initializeBoard(&G, start_player);
-	history_reset();
+	history_reset(&H);
+
+	if (watch_port) {
+		if (spectate_open(watch_port, &G, &H, start_player) == 0)
+			printf("Spectators can watch on port %d.\n", watch_port);
+		else
+			puts("Spectator port unavailable: playing without spectators.");
+	}
 
-	char my_player = is_server ? 'A' : 'B';
 	printf("You are player %c.\n", my_player);
 	ui_print_board(&G, 1);
 
+	g_peer.head = 0;
+	g_peer.len = 0;
+	g_peer.closed = 0;
+	g_peer.error = 0;
+	g_peer.midway = 0;
+	g_peer.player = (my_player == 'A') ? 'B' : 'A';
+	g_peer.resigned = 0;
+	event_watch(g_peer.conn.fd, on_peer_readable, &g_peer);
+	peer_decode(&g_peer);   // frames that arrived along with the handshake
+	input_key_mode(1);
+
 	int finished = 0;
 	while (!finished) {
 		if (G.current == my_player) {
-			int res = net_local_turn(&G, use_anim, anim_ms, sockfd);
+			int res = net_local_turn(&G, &H, use_anim, anim_ms);
 			if (res == -1) {
 				puts("Network error. Ending game.");
 				break;
@@ -498,7 +811,7 @@ static void run_network_game_loop(int sockfd, int is_server, int use_anim, int a
 			if (res == 1)
 				finished = 1;
 		} else {
-			int res = net_remote_turn(&G, use_anim, anim_ms, sockfd);
+			int res = net_remote_turn(&G, &H, use_anim, anim_ms);
 			if (res == -1) {
 				puts("Network error. Ending game.");
 				break;
@@ -507,6 +820,132 @@ static void run_network_game_loop(int sockfd, int is_server, int use_anim, int a
 				finished = 1;
 		}
 	}
+
+	input_key_mode(0);
+	event_unwatch(g_peer.conn.fd);
+	spectate_close();
+	if (finished) {
+		int players = (my_player == 'A') ? (RECORD_HUMAN | RECORD_REMOTE << 4)
+		                                 : (RECORD_REMOTE | RECORD_HUMAN << 4);
+		record_game(&G, &H, start_player, players, NULL, g_peer.resigned);
+	}
+}
+
+// Applies one frame of a spectator stream: 1 when the game is over, 0 to
+// continue, -1 on a protocol error or a desync
+static int watch_apply(Board *G, History *H, int *joined, const NetFrame *f,
+                       int use_anim, int anim_ms) {
+	if (f->type == NET_CATCHUP) {
+		int played = f->len - 2;
+		if (*joined || f->len < 2 || f->payload[1] > played ||
+		    (f->payload[0] != 'A' && f->payload[0] != 'B'))
+			return -1;
+		initializeBoard(G, (char)f->payload[0]);
+		history_reset(H);
+		for (int i = 0; i < played; i++) {
+			int col0 = f->payload[2 + i];
+			int row = (col0 < COLS) ? game_drop(G, col0, G->current) : -1;
+			if (row == -1)
+				return -1;
+			history_record_move(H, row, col0, G->current);
+			switch_player(G);
+		}
+		if (played > f->payload[1])
+			history_undo(H, G, played - f->payload[1]);
+		*joined = 1;
+		printf("Watching a game with %d moves played.\n", f->payload[1]);
+		ui_print_board(G, 1);
+		return peer_in_sync(G, f) ? 0 : -1;
+	}
+	if (!*joined)
+		return -1;
+
+	if (f->type == NET_RESIGN && f->len == 1) {
+		printf("Player %c resigned. Game over.\n", f->payload[0]);
+		return 1;
+	}
+	if (f->type == NET_UNDO || f->type == NET_REDO) {
+		int ok = (f->type == NET_UNDO) ? history_undo(H, G, 1) : history_redo(H, G, 1);
+		if (ok)
+			ui_print_board(G, 1);
+		return (ok && peer_in_sync(G, f)) ? 0 : -1;
+	}
+	if (f->type == NET_MOVE && f->len == 1 && f->payload[0] < COLS) {
+		int col0 = f->payload[0];
+		int row = do_drop(G, col0, use_anim, anim_ms);
+		if (row == -1)
+			return -1;
+		history_record_move(H, row, col0, G->current);
+		if (!use_anim)
+			ui_print_board(G, 1);
+		if (!peer_in_sync(G, f))
+			return -1;
+
+		if (checkWin(G, G->current)) {
+			printf("Player %c wins!\n", G->current);
+			return 1;
+		}
+		if (game_is_full(G)) {
+			puts("It's a draw! Board is full.");
+			return 1;
+		}
+		switch_player(G);
+		return 0;
+	}
+	return -1;
+}
+
+// Follows a hosted game until it ends, the host leaves, or 'q'
+static void run_watch_loop(int use_anim, int anim_ms) {
+	Board G;
+	History H;
+	int joined = 0;
+	int over = 0;
+	initializeBoard(&G, 'A');
+	history_reset(&H);
+
+	g_peer.head = 0;
+	g_peer.len = 0;
+	g_peer.closed = 0;
+	g_peer.error = 0;
+	g_peer.midway = 1;
+	g_peer.player = '?';
+	event_watch(g_peer.conn.fd, on_peer_readable, &g_peer);
+	input_key_mode(1);
+	puts("Spectating. Press 'q' to stop watching.");
+	fflush(stdout);
+
+	for (;;) {
+		NetFrame f;
+		if (!peer_pop(&g_peer, &f)) {
+			if (g_peer.closed) {
+				if (!over)
+					print_peer_error(g_peer.error);
+				break;
+			}
+			if (!input_has_line()) {
+				event_run_once(-1);
+				continue;
+			}
+			char line[128];
+			int col0;
+			read_line(line, sizeof line);
+			if (parse_action(line, &col0) == -1)
+				break;
+			continue;
+		}
+
+		int r = watch_apply(&G, &H, &joined, &f, use_anim, anim_ms);
+		if (r < 0) {
+			puts("Protocol error: bad frame in the spectator stream.");
+			break;
+		}
+		if (r > 0)
+			over = 1;
+	}
+
+	input_key_mode(0);
+	event_unwatch(g_peer.conn.fd);
 }
 
 // Check the ip address of the host
@@ -538,6 +977,8 @@ char* getIp() {
 void run_human_online(int use_anim, int anim_ms) {
 	char line[128];
 	int is_server = 0;
+	int watching = 0;
+	char my_player = 'A';
 	int port = 4444;
 	int sockfd = -1;
 	char start_player = 'A';
@@ -545,9 +986,9 @@ void run_human_online(int use_anim, int anim_ms) {
 	g_allow_chat = 0;
 
 	for (;;) {
-		printf("Online mode. Do you want to host (h) or join (j)? ");
+		printf("Online mode. Do you want to host (h), join (j) or watch (w)? ");
 		fflush(stdout);
-		if (!fgets(line, sizeof line, stdin)) {
+		if (!read_line(line, sizeof line)) {
 			puts("\nInput ended. Exiting online mode.");
 			return;
 		}
@@ -559,13 +1000,18 @@ void run_human_online(int use_anim, int anim_ms) {
 			is_server = 0;
 			break;
 		}
-		puts("Invalid choice. Please enter 'h' to host or 'j' to join.");
+		if (line[0] == 'w' || line[0] == 'W') {
+			watching = 1;
+			port = 4445;
+			break;
+		}
+		puts("Invalid choice. Please enter 'h' to host, 'j' to join or 'w' to watch.");
 	}
 
 	if (is_server) {
 		printf("Enter port to listen on (default 4444): ");
 		fflush(stdout);
-		if (fgets(line, sizeof line, stdin) && line[0] != '\n') {
+		if (read_line(line, sizeof line) && line[0] != '\n') {
 			int p = atoi(line);
 			if (p > 0 && p < 65536)
 				port = p;
@@ -578,11 +1024,12 @@ void run_human_online(int use_anim, int anim_ms) {
 			return;
 		}
 		puts("Friend connected!");
+		net_conn_init(&g_peer.conn, sockfd);
 
 		for (;;) {
 			printf("Who plays first, player A or player B? ");
 			fflush(stdout);
-			if (!fgets(line, sizeof line, stdin)) {
+			if (!read_line(line, sizeof line)) {
 				puts("\nInput ended. Exiting online mode.");
 				close(sockfd);
 				return;
@@ -598,7 +1045,8 @@ void run_human_online(int use_anim, int anim_ms) {
 			puts("Invalid choice. Please enter 'A' or 'B'.");
 		}
 
-		if (net_send_action(sockfd, (unsigned char)start_player) != 0) {
+		uint8_t setup[2] = { 'B', (uint8_t)start_player };
+		if (net_send(&g_peer.conn, NET_MATCH, 0, setup, 2) != 0) {
 			puts("Failed to send starting player to client.");
 			close(sockfd);
 			return;
@@ -609,7 +1057,7 @@ void run_human_online(int use_anim, int anim_ms) {
 
 		printf("Enter server IP address: ");
 		fflush(stdout);
-		if (!fgets(ip, sizeof ip, stdin)) {
+		if (!read_line(ip, sizeof ip)) {
 			puts("\nInput ended. Exiting online mode.");
 			return;
 		}
@@ -624,14 +1072,15 @@ void run_human_online(int use_anim, int anim_ms) {
 			return;
 		}
 
-		printf("Enter server port (default 4444): ");
+		printf("Enter server port (default %d): ", port);
 		fflush(stdout);
-		if (fgets(line, sizeof line, stdin) && line[0] != '\n') {
+		if (read_line(line, sizeof line) && line[0] != '\n') {
 			int p = atoi(line);
 			if (p > 0 && p < 65536)
 				port = p;
 		}
 
+		my_player = 'B';
 		printf("Connecting to %s:%d...\n", ip, port);
 		sockfd = net_open_client(ip, port);
 		if (sockfd < 0) {
@@ -640,19 +1089,259 @@ void run_human_online(int use_anim, int anim_ms) {
 		}
 		puts("Connected to server!");
 
-		unsigned char sp = 0;
-		if (net_recv_byte(sockfd, &sp) != 0) {
-			puts("Failed to receive starting player from server.");
+		net_conn_init(&g_peer.conn, sockfd);
+		if (watching) {
+			run_watch_loop(use_anim, anim_ms);
+			close(sockfd);
+			return;
+		}
+
+		// A match server (connect4-server) says hello first and assigns
+		// the side once an opponent arrives; a friend hosting is always A
+		NetFrame f;
+		int r = net_recv(&g_peer.conn, &f);
+		if (r == 1 && f.type == NET_HELLO) {
+			puts("Joined a match server. Waiting for an opponent...");
+			fflush(stdout);
+			r = net_recv(&g_peer.conn, &f);
+		}
+		if (r != 1 || f.type != NET_MATCH || f.len != 2) {
+			if (r == NET_ERR_VERSION)
+				puts("The server uses a different protocol version.");
+			else
+				puts("Failed to receive match setup from server.");
 			close(sockfd);
 			return;
 		}
-		if (sp == 'A' || sp == 'B')
-			start_player = (char)sp;
+		if (f.payload[0] == 'A' || f.payload[0] == 'B')
+			my_player = (char)f.payload[0];
+		if (f.payload[1] == 'A' || f.payload[1] == 'B')
+			start_player = (char)f.payload[1];
 		else
 			start_player = 'A';
 		printf("Player %c will start.\n", start_player);
 	}
 
-	run_network_game_loop(sockfd, is_server, use_anim, anim_ms, start_player);
+	// The host takes spectators on the next port
+	run_network_game_loop(my_player, use_anim, anim_ms, start_player,
+		(is_server && port < 65535) ? port + 1 : 0);
 	close(sockfd);
 }
+
+// Headless games: scripts and bot-vs-bot with no menus, prompts or board
+// output, through the same play_move as interactive games.
+
+static const char* outcome_names[] = { "unfinished", "A", "B", "draw" };
+
+// One JSON line per game: how it ended and the moves left on the board
+static void headless_report(FILE* out, long game, const Board* G, const History* H,
+                            int undos, int redos, const char* error) {
+	char moves[MAX_MOVES + 1];
+	for (int i = 0; i < H->current_index; i++)
+		moves[i] = (char)('1' + H->moves[i].col);
+	moves[H->current_index] = '\0';
+
+	fprintf(out, "{\"game\": %ld, \"result\": \"%s\", \"plies\": %d, \"moves\": \"%s\"",
+		game, outcome_names[record_outcome(G)], H->current_index, moves);
+	if (undos || redos)
+		fprintf(out, ", \"undos\": %d, \"redos\": %d", undos, redos);
+	if (error)
+		fprintf(out, ", \"error\": \"%s\"", error);
+	fputs("}\n", out);
+}
+
+// Plays a script: columns 1-7, 'u' and 'r' to undo and redo one move,
+// blanks skipped. Stops with *error at a full column, a move after the
+// game ended or any other character.
+static void headless_script(Board* G, History* H, const char* script,
+                            int* undos, int* redos, const char** error) {
+	int over = 0;
+	for (const char* p = script; *p; p++) {
+		if (*p == ' ' || *p == '\t' || *p == '\r')
+			continue;
+		if (*p == 'u') {
+			if (history_undo(H, G, 1)) {
+				(*undos)++;
+				over = 0;
+			}
+			continue;
+		}
+		if (*p == 'r') {
+			if (history_redo(H, G, 1)) {
+				(*redos)++;
+				over = record_outcome(G) != RECORD_UNFINISHED;
+			}
+			continue;
+		}
+		if (*p < '1' || *p >= '1' + COLS) {
+			*error = "bad character";
+			return;
+		}
+		if (over) {
+			*error = "move after the end of the game";
+			return;
+		}
+		int r = play_move(G, H, *p - '1', 0, 0);
+		if (r == -1) {
+			*error = "column full";
+			return;
+		}
+		over = r > 0;
+	}
+}
+
+static int headless_bot_move(Board* G, int level, const BotLimits* hard) {
+	if (level == 1)
+		return bot_choose_move(G);
+	if (level == 2)
+		return bot_choose_move_medium(G);
+	return pick_best_move(G, hard, NULL);
+}
+
+static void headless_bots(Board* G, History* H, const HeadlessOptions* opt,
+                          const BotLimits* hard, const char** error) {
+	for (;;) {
+		int level = (G->current == 'A') ? opt->bot_a : opt->bot_b;
+		int col0  = headless_bot_move(G, level, hard);
+		int r     = (col0 < 0) ? -1 : play_move(G, H, col0, 0, 0);
+		if (r == -1) {
+			*error = "no legal move from the bot";
+			return;
+		}
+		if (r > 0)
+			return;
+	}
+}
+
+// Script lines, without blank lines and # comments, of any length; NULL
+// on a read or allocation error, so no game is dropped silently
+static char** headless_load(const char* path, int* n) {
+	FILE* f = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+	if (!f)
+		return NULL;
+
+	char**  lines = malloc(sizeof(*lines));
+	int     cap   = 1;
+	char*   buf   = NULL;
+	size_t  size  = 0;
+	int     ok    = lines != NULL;
+	*n = 0;
+	while (ok && getline(&buf, &size, f) != -1) {
+		buf[strcspn(buf, "#\r\n")] = '\0';
+		if (buf[strspn(buf, " \t")] == '\0')
+			continue;
+		if (*n == cap) {
+			char** grown = realloc(lines, 2 * (size_t)cap * sizeof(*lines));
+			if (!grown) {
+				ok = 0;
+				break;
+			}
+			lines = grown;
+			cap  *= 2;
+		}
+		if (!(lines[*n] = strdup(buf)))
+			ok = 0;
+		else
+			(*n)++;
+	}
+	if (ferror(f))
+		ok = 0;
+	free(buf);
+	if (f != stdin)
+		fclose(f);
+
+	if (!ok) {
+		for (int i = 0; i < *n; i++)
+			free(lines[i]);
+		free(lines);
+		return NULL;
+	}
+	return lines;
+}
+
+static int record_kind(int level) {
+	return level == 1 ? RECORD_RANDOM : level == 2 ? RECORD_MEDIUM : RECORD_HARD;
+}
+
+int run_headless(const HeadlessOptions* opt, FILE* out) {
+	int    n_lines = 0;
+	char** lines   = NULL;
+	if (opt->script) {
+		lines = headless_load(opt->script, &n_lines);
+		if (!lines) {
+			fprintf(stderr, "Cannot load script %s.\n", opt->script);
+			return 2;
+		}
+	}
+	int n_games = n_lines + (opt->moves != NULL) + (opt->bot_a && opt->bot_b);
+
+	if (g_record_path && !(g_record_out = record_append(g_record_path))) {
+		fprintf(stderr, "Cannot append game records to %s.\n", g_record_path);
+		for (int i = 0; i < n_lines; i++)
+			free(lines[i]);
+		free(lines);
+		return 2;
+	}
+
+	BotLimits hard = bot_limits[3];
+	if (opt->depth) {
+		hard.max_depth = opt->depth;
+		hard.time_ms   = 0;
+	}
+	if (opt->bot_a == 3 || opt->bot_b == 3) {
+		zobrist_init();
+		tt_open(NULL);
+		book_init();
+	}
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	long game = 0, errors = 0;
+	for (int round = 0; round < opt->games; round++) {
+		for (int i = 0; i < n_games; i++) {
+			Board       G;
+			History     H;
+			int         undos = 0, redos = 0;
+			const char* error = NULL;
+			initializeBoard(&G, opt->first);
+			history_reset(&H);
+
+			int players = RECORD_HUMAN | RECORD_HUMAN << 4;
+			if (i < n_lines) {
+				headless_script(&G, &H, lines[i], &undos, &redos, &error);
+			} else if (i == n_lines && opt->moves) {
+				headless_script(&G, &H, opt->moves, &undos, &redos, &error);
+			} else {
+				headless_bots(&G, &H, opt, &hard, &error);
+				players = record_kind(opt->bot_a) | record_kind(opt->bot_b) << 4;
+			}
+
+			headless_report(out, ++game, &G, &H, undos, redos, error);
+			if (error)
+				errors++;
+			else
+				record_game(&G, &H, opt->first, players, &hard, 0);
+		}
+	}
+	fflush(out);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	double secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-9;
+	fprintf(stderr, "%ld games, %ld errors in %.3f s: %.0f games/s\n", game, errors, secs,
+		secs > 0 ? game / secs : 0.0);
+
+	if (g_record_out) {
+		if (fclose(g_record_out) != 0) {
+			fprintf(stderr, "Could not save the games to %s.\n", g_record_path);
+			errors++;
+		}
+		g_record_out = NULL;
+	}
+	for (int i = 0; i < n_lines; i++)
+		free(lines[i]);
+	free(lines);
+	if (opt->bot_a == 3 || opt->bot_b == 3)
+		shutdown_bot();
+	return errors ? 1 : 0;
+}
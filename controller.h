@@ -1,8 +1,31 @@
 #ifndef CONTROLLER_H
 #define CONTROLLER_H
 
+#include <stdio.h>
+
 void run_human_vs_human(int use_anim, int anim_ms);
 void run_vs_bot(int use_anim, int anim_ms, int difficulty);
 void run_human_online(int use_anim, int anim_ms);
+/* Write search statistics of the hard bot to out (NULL = off). */
+void controller_set_stats(FILE* out);
+/* Headless games (play.c --moves, --script, --bot-vs-bot): no menus,
+ * prompts or board output. A script is a line of columns 1-7, with 'u' and
+ * 'r' to undo and redo one move. Bot levels are 1 easy, 2 medium, 3 hard. */
+typedef struct {
+	const char* moves;     /* one script, NULL = none */
+	const char* script;    /* file of scripts, one game per line ("-" = stdin) */
+	int bot_a, bot_b;      /* bot-vs-bot levels, 0 = no bot game */
+	int depth;             /* hard bot depth with no time limit, 0 = usual budget */
+	int games;             /* rounds over all of the above */
+	char first;            /* starting player */
+} HeadlessOptions;
+
+/* Plays every game, one JSON result line each on out, and prints games/s
+ * to stderr. 0, or 1 if a script was invalid (2 if the script or the
+ * record file can't be opened); with recording on, all games stream into
+ * one open record file. */
+int run_headless(const HeadlessOptions* opt, FILE* out);
+/* Append finished games to the record file at path (record.h, NULL = off). */
+void controller_set_record(const char* path);
 
 #endif
\ No newline at end of file
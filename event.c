@@ -0,0 +1,171 @@
+#define _POSIX_C_SOURCE 200112L
+#include "event.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+	int       fd;
+	EventFdFn fn;
+	void*     ctx;
+} EventWatch;
+
+typedef struct {
+	int          id;          // 0 = free slot
+	long long    deadline_ns;
+	EventTimerFn fn;
+	void*        ctx;
+} EventTimer;
+
+static EventWatch watches[EVENT_MAX_FDS];
+static int        n_watches = 0;
+
+static EventTimer timers[EVENT_MAX_TIMERS];
+static int        next_timer_id = 1;
+
+// Self-pipe: threads write a byte, the loop drains it
+static int notify_pipe[2] = { -1, -1 };
+
+static long long event_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void notify_drain(int fd, void* ctx) {
+	(void)ctx;
+	char buf[64];
+	while (read(fd, buf, sizeof buf) > 0) {}
+}
+
+static void notify_init(void) {
+	if (notify_pipe[0] >= 0) return;
+	if (pipe(notify_pipe) != 0) {
+		notify_pipe[0] = notify_pipe[1] = -1;
+		return;
+	}
+	for (int i = 0; i < 2; i++) {
+		fcntl(notify_pipe[i], F_SETFL, fcntl(notify_pipe[i], F_GETFL) | O_NONBLOCK);
+		fcntl(notify_pipe[i], F_SETFD, FD_CLOEXEC);
+	}
+	event_watch(notify_pipe[0], notify_drain, NULL);
+}
+
+int event_watch(int fd, EventFdFn fn, void* ctx) {
+	for (int i = 0; i < n_watches; i++) {
+		if (watches[i].fd == fd) {
+			watches[i].fn  = fn;
+			watches[i].ctx = ctx;
+			return 0;
+		}
+	}
+	if (n_watches == EVENT_MAX_FDS)
+		return -1;
+	watches[n_watches++] = (EventWatch){ fd, fn, ctx };
+	return 0;
+}
+
+void event_unwatch(int fd) {
+	for (int i = 0; i < n_watches; i++) {
+		if (watches[i].fd == fd) {
+			watches[i] = watches[--n_watches];
+			return;
+		}
+	}
+}
+
+int event_timer(int ms, EventTimerFn fn, void* ctx) {
+	for (int i = 0; i < EVENT_MAX_TIMERS; i++) {
+		if (timers[i].id) continue;
+		if (ms < 0) ms = 0;
+		timers[i].id          = next_timer_id++;
+		timers[i].deadline_ns = event_now_ns() + (long long)ms * 1000000LL;
+		timers[i].fn          = fn;
+		timers[i].ctx         = ctx;
+		if (next_timer_id <= 0) next_timer_id = 1;
+		return timers[i].id;
+	}
+	return -1;
+}
+
+void event_cancel(int id) {
+	for (int i = 0; i < EVENT_MAX_TIMERS; i++) {
+		if (timers[i].id == id && id > 0)
+			timers[i].id = 0;
+	}
+}
+
+void event_notify(void) {
+	if (notify_pipe[1] < 0) return;
+	char b = 1;
+	ssize_t n = write(notify_pipe[1], &b, 1);   // a full pipe already wakes the loop
+	(void)n;
+}
+
+void event_run_once(int timeout_ms) {
+	notify_init();
+
+	// The nearest timer shortens the wait
+	long long now = event_now_ns();
+	for (int i = 0; i < EVENT_MAX_TIMERS; i++) {
+		if (!timers[i].id) continue;
+		long long left = timers[i].deadline_ns - now;
+		int ms = left <= 0 ? 0 : (int)((left + 999999) / 1000000);
+		if (timeout_ms < 0 || ms < timeout_ms)
+			timeout_ms = ms;
+	}
+
+	struct pollfd fds[EVENT_MAX_FDS];
+	int n = n_watches;
+	for (int i = 0; i < n; i++) {
+		fds[i].fd      = watches[i].fd;
+		fds[i].events  = POLLIN;
+		fds[i].revents = 0;
+	}
+
+	int ready = poll(fds, (nfds_t)n, timeout_ms);
+	if (ready < 0 && errno != EINTR)
+		return;
+
+	// Callbacks may add or remove watches: look each one up again
+	for (int i = 0; ready > 0 && i < n; i++) {
+		if (!fds[i].revents) continue;
+		for (int j = 0; j < n_watches; j++) {
+			if (watches[j].fd == fds[i].fd) {
+				watches[j].fn(watches[j].fd, watches[j].ctx);
+				break;
+			}
+		}
+	}
+
+	now = event_now_ns();
+	for (int i = 0; i < EVENT_MAX_TIMERS; i++) {
+		if (!timers[i].id || timers[i].deadline_ns > now) continue;
+		EventTimer t = timers[i];
+		timers[i].id = 0;
+		t.fn(t.ctx);
+	}
+}
+
+void event_run_until(const int* flag) {
+	notify_init();
+	while (!__atomic_load_n(flag, __ATOMIC_ACQUIRE))
+		event_run_once(-1);
+}
+
+static void set_flag(void* ctx) {
+	*(int*)ctx = 1;
+}
+
+void event_sleep(int ms) {
+	int done = 0;
+	if (event_timer(ms, set_flag, &done) < 0) {
+		// Out of timers: plain wait, still without spinning
+		poll(NULL, 0, ms);
+		return;
+	}
+	event_run_until(&done);
+}
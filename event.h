@@ -0,0 +1,42 @@
+#ifndef EVENT_H
+#define EVENT_H
+
+#pragma once
+
+/* Single-threaded poll() event loop.
+ *
+ * Every wait in the game goes through here, so one blocked source never
+ * freezes the others: stdin (owned by input.c), the peer socket, animation
+ * timers, and wake-ups from search threads. Callbacks run on the main
+ * thread from event_run_once(); waiting never spins.
+ */
+
+typedef void (*EventFdFn)(int fd, void* ctx);
+typedef void (*EventTimerFn)(void* ctx);
+
+#define EVENT_MAX_FDS    8
+#define EVENT_MAX_TIMERS 8
+
+/* Calls fn when fd is readable, hung up or in error. 0, or -1 if full. */
+int  event_watch(int fd, EventFdFn fn, void* ctx);
+void event_unwatch(int fd);
+
+/* One-shot timer after ms milliseconds. Returns an id for event_cancel(),
+ * or -1 if full. */
+int  event_timer(int ms, EventTimerFn fn, void* ctx);
+void event_cancel(int id);
+
+/* Wakes event_run_once() from any thread (self-pipe). */
+void event_notify(void);
+
+/* Waits up to timeout_ms (-1 = no limit) and dispatches what is ready. */
+void event_run_once(int timeout_ms);
+
+/* Runs the loop until *flag is set, by a callback or by another thread
+ * followed by event_notify(). */
+void event_run_until(const int* flag);
+
+/* Runs the loop for ms milliseconds: input and sockets stay live. */
+void event_sleep(int ms);
+
+#endif
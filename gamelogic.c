@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+_Static_assert(ROWS == 6 && COLS == 7, "GAME_*_MASK constants assume a 7x6 board");
+
 // static int count_connected_checkers(const Board* g, int r, int c, int rowDir, int colDir, char player) {
 // 	int streak = 0;
 // 	int temp_r = r;
@@ -58,12 +60,7 @@ void initializeBoard(Board* g, char turn) {
 int game_can_drop(const Board* g, int col) {
 	if (col < 0 || col >= COLS)
 		return -1;
-	for (int r = ROWS - 1; r >= 0; r--) {
-		uint64_t bit = 1ULL << (r + col * 7);
-		if (!(g->mask & bit))
-			return r;
-	}
-	return -1;
+	return game_landing_row(g, col);
 }
 
 int game_drop(Board* g, int col, char player) {
@@ -115,11 +112,20 @@ int checkWin(const Board* g, char player) {
 }
 
 int checkDraw(const Board* g) {
-    for (int c = 0; c < COLS; c++) {
-        if (game_can_drop(g, c) != -1)
-            return 0;
-    }
-    return 1;
+	return game_is_full(g);
+}
+
+int game_play_moves(Board* g, const char* moves) {
+	int n = 0;
+	for (const char* p = moves; *p; p++) {
+		if (*p < '1' || *p > '0' + COLS)
+			return -1;
+		if (game_drop(g, *p - '1', g->current) == -1)
+			return -1;
+		g->current = (g->current == 'A') ? 'B' : 'A';
+		n++;
+	}
+	return n;
 }
 
 // void board_to_string(const Board* g, char out[ROWS*COLS + 1]) {
@@ -10,6 +10,14 @@
 #define COLS 7
 #define EMPTY '.'
 
+/* Bitboards: bit r + 7c is row r (0 = top) of column c, and bit 6 of each
+ * column is always empty. A column fills from its bottom square (bit 5)
+ * towards bit 0. */
+#define GAME_BOARD_MASK  0xFDFBF7EFDFBFULL   /* the 42 squares */
+#define GAME_BOTTOM_MASK 0x810204081020ULL   /* bottom row */
+#define GAME_TOP_MASK    0x040810204081ULL   /* top row */
+#define GAME_COL_MASK(c) (((1ULL << ROWS) - 1) << (7 * (c)))
+
 typedef struct {
 	uint64_t playerA;
 	uint64_t playerB;
@@ -26,6 +34,35 @@ int game_can_drop(const Board* g, int col);
 int game_drop(Board* g, int col, char player);
 int checkWin(const Board* g, char player);
 int checkDraw(const Board* g);
+/* Landing square of every column that isn't full: the square above each
+ * column's top stone, or the bottom square of an empty column. Stones
+ * stack towards bit 0 here, so this is ((mask >> 1) | bottom) & ~mask
+ * instead of the mask + bottom of bottom-up layouts. */
+static inline uint64_t game_playable(const Board* g) {
+	return ((g->mask >> 1) | GAME_BOTTOM_MASK) & ~g->mask & GAME_BOARD_MASK;
+}
+
+/* Row a stone dropped in column col (0..COLS-1) lands on, -1 if the column
+ * is full. The empty squares of a column are its low bits, so the lowest
+ * stone is one ctz away; the spacer bit stops it on a full column. */
+static inline int game_landing_row(const Board* g, int col) {
+	return __builtin_ctzll((g->mask >> (7 * col)) | (1ULL << ROWS)) - 1;
+}
+
+static inline int game_is_full(const Board* g) {
+	return g->mask == GAME_BOARD_MASK;
+}
+
+/* Columns that aren't full, bit c for column c. A column is open while its
+ * top square is empty; one multiply gathers the 7 top squares, 7 bits
+ * apart, into bits 36..42 without carries. */
+static inline int game_legal_moves(const Board* g) {
+	return (int)((((~g->mask & GAME_TOP_MASK) * 0x1041041041ULL) >> 36) & 0x7F);
+}
+
+/* Plays a string of 1-based column digits (e.g. "4453") from the current
+ * position, alternating g->current. Returns moves played or -1 if illegal. */
+int game_play_moves(Board* g, const char* moves);
 // void board_to_string(const Board* g, char out[ROWS*COLS + 1]);
 // void string_to_board(Board* g, const char* s);
 
@@ -1,53 +1,49 @@
 #include "history.h"
 
-static Move history[MAX_MOVES];
-static int move_count = 0;
-static int current_index = 0;
-
-void history_reset(void) {
-	move_count = 0;
-	current_index = 0;
+void history_reset(History* h) {
+	h->move_count = 0;
+	h->current_index = 0;
 }
 
-void history_record_move(int row, int col, char player) {
-	if (current_index < move_count) {
-		move_count = current_index;
+void history_record_move(History* h, int row, int col, char player) {
+	if (h->current_index < h->move_count) {
+		h->move_count = h->current_index;
 	}
-	if (move_count < MAX_MOVES) {
-		history[move_count].row = row;
-		history[move_count].col = col;
-		history[move_count].player = player;
-		move_count++;
-		current_index = move_count;
+	if (h->move_count < MAX_MOVES) {
+		h->moves[h->move_count].row = row;
+		h->moves[h->move_count].col = col;
+		h->moves[h->move_count].player = player;
+		h->move_count++;
+		h->current_index = h->move_count;
 	}
 }
 
-int history_undo(Board* G, int steps) {
-	if (current_index == 0)
+int history_undo(History* h, Board* G, int steps) {
+	if (h->current_index == 0)
 		return 0;
 
 	for (int i = 0; i < steps; i++) {
-		if (current_index == 0)
+		if (h->current_index == 0)
 			return i > 0;
-		current_index--;
-		Move m = history[current_index];
+		h->current_index--;
+		Move m = h->moves[h->current_index];
 		setChar(G, m.row, m.col, EMPTY);
 		G->current = m.player;
 	}
 	return 1;
 }
 
-int history_redo(Board* G, int steps) {
-	if (current_index == move_count)
+int history_redo(History* h, Board* G, int steps) {
+	if (h->current_index == h->move_count)
 		return 0;
 
-	Move m = history[current_index];
+	Move m = h->moves[h->current_index];
 	for (int i = 0; i < steps; i++) {
-		if (current_index == move_count)
+		if (h->current_index == h->move_count)
 			return i > 0;
-		m = history[current_index];
+		m = h->moves[h->current_index];
 		setChar(G, m.row, m.col, m.player);
-		current_index++;
+		h->current_index++;
 	}
 
 	if (m.player == 'A')
@@ -58,15 +54,15 @@ int history_redo(Board* G, int steps) {
 	return 1;
 }
 
-int history_get_last_move(Move* out) {
+int history_get_last_move(const History* h, Move* out) {
 	if (!out) return 0;
 
 	// current_index points to "next" move to be played/redone,
 	// so the last actual move is at current_index - 1.
-	if (current_index <= 0) {
+	if (h->current_index <= 0) {
 		return 0; // no moves yet
 	}
 
-	*out = history[current_index - 1];
+	*out = h->moves[h->current_index - 1];
 	return 1;
 }
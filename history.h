@@ -11,12 +11,19 @@ typedef struct {
 	char player;
 } Move;
 
-void history_reset(void);
-void history_record_move(int row, int col, char player);
-int history_undo(Board* G, int steps);
-int history_redo(Board* G, int steps);
+/* Undo/redo stack of one game. Each game (or server match) owns one. */
+typedef struct {
+	Move moves[MAX_MOVES];
+	int move_count;
+	int current_index;   /* next move to be played or redone */
+} History;
+
+void history_reset(History* h);
+void history_record_move(History* h, int row, int col, char player);
+int history_undo(History* h, Board* G, int steps);
+int history_redo(History* h, Board* G, int steps);
 
 // NEW: get last played move (returns 1 on success, 0 if none)
-int history_get_last_move(Move* out);
+int history_get_last_move(const History* h, Move* out);
 
-#endif
\ No newline at end of file
+#endif
@@ -1,16 +1,119 @@
+#define _POSIX_C_SOURCE 200112L
 #include "input.h"
 #include "gamelogic.h"
+#include "event.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define INPUT_BUF 4096
+
+static char in_buf[INPUT_BUF];
+static int  in_len = 0;
+static int  in_eof = 0;
+static int  in_watching = 0;
+
+static int raw_enabled = 0;      // --raw given and stdin is a terminal
+static int key_mode = 0;         // terminal currently non-canonical
+static struct termios saved_termios;
+
+static void on_stdin(int fd, void* ctx) {
+	(void)ctx;
+	if (in_len == INPUT_BUF) {
+		// Runaway line: drop it rather than stall the loop
+		in_len = 0;
+	}
+	ssize_t n = read(fd, in_buf + in_len, (size_t)(INPUT_BUF - in_len));
+	if (n > 0) {
+		if (key_mode) {
+			// Echo is left to the terminal; finish the line on screen
+			putchar('\n');
+			fflush(stdout);
+		}
+		in_len += (int)n;
+		return;
+	}
+	in_eof = 1;
+	event_unwatch(fd);
+	in_watching = 0;
+}
+
+static void input_watch(void) {
+	if (in_watching || in_eof) return;
+	if (event_watch(STDIN_FILENO, on_stdin, NULL) == 0)
+		in_watching = 1;
+}
+
+// Length of the first complete command in the buffer, 0 if none. In key
+// mode every non-blank byte is a command of its own.
+static int line_length(void) {
+	if (key_mode) {
+		int skip = 0;
+		while (skip < in_len && isspace((unsigned char)in_buf[skip]))
+			skip++;
+		return skip < in_len ? skip + 1 : 0;
+	}
+	char* nl = memchr(in_buf, '\n', (size_t)in_len);
+	if (nl)
+		return (int)(nl - in_buf) + 1;
+	return in_eof ? in_len : 0;
+}
+
+int input_has_line(void) {
+	input_watch();
+	return line_length() > 0;
+}
 
 int read_line(char *buf, int n) {
-	if (!fgets(buf, n, stdin))
-		return 0;
+	int len;
+
+	fflush(stdout);
+	input_watch();
+	while ((len = line_length()) == 0) {
+		if (in_eof)
+			return 0;
+		event_run_once(-1);
+	}
+
+	// Too long for buf: keep the start, drop the rest of the line
+	int copy = len < n - 1 ? len : n - 1;
+	memcpy(buf, in_buf, (size_t)copy);
+	buf[copy] = '\0';
+	in_len -= len;
+	memmove(in_buf, in_buf + len, (size_t)in_len);
 	return 1;
 }
 
+static void restore_terminal(void) {
+	if (key_mode)
+		tcsetattr(STDIN_FILENO, TCSANOW, &saved_termios);
+	key_mode = 0;
+}
+
+void input_set_raw(int on) {
+	raw_enabled = on && isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved_termios) == 0;
+	if (raw_enabled)
+		atexit(restore_terminal);
+}
+
+void input_key_mode(int on) {
+	if (!raw_enabled || on == key_mode) return;
+	if (!on) {
+		restore_terminal();
+		return;
+	}
+	struct termios t = saved_termios;
+	t.c_lflag &= ~(tcflag_t)ICANON;
+	t.c_cc[VMIN]  = 1;
+	t.c_cc[VTIME] = 0;
+	if (tcsetattr(STDIN_FILENO, TCSANOW, &t) == 0)
+		key_mode = 1;
+}
+
 int parse_action(const char *s, int *out_col0) {
 	while (isspace((unsigned char)*s))
 		s++;
@@ -31,4 +134,4 @@ int parse_action(const char *s, int *out_col0) {
 
 	*out_col0 = (int)(v - 1);
 	return 1;
-}
\ No newline at end of file
+}
@@ -1,7 +1,24 @@
 #ifndef INPUT_H
 #define INPUT_H
 
+/* input.c is the only reader of stdin. It watches fd 0 through the event
+ * loop (event.h) and assembles lines in its own buffer, so waiting for the
+ * player never blocks sockets, timers or search notifications. Nothing
+ * else may read stdin with stdio: fgets would not see the buffer. */
+
+/* Blocks (running the event loop) until a line is in buf, like fgets.
+ * Returns 0 at end of input. */
 int read_line(char *buf, int n);
+
+/* 1 if read_line would return at once with a line, without waiting. */
+int input_has_line(void);
+
+/* --raw: during games a single keypress is a whole command on a terminal.
+ * input_key_mode switches the terminal in and out of that mode; it does
+ * nothing without --raw or when stdin is not a tty. */
+void input_set_raw(int on);
+void input_key_mode(int on);
+
 int parse_action(const char *s, int *out_col0);
 
-#endif
\ No newline at end of file
+#endif
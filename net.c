@@ -1,17 +1,19 @@
 #include "net.h"
 
 #include <stdio.h>
+#include <errno.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <arpa/inet.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
-int net_open_server(int port) {
+int net_listen(int port, int backlog) {
 	int server_fd = -1;
-	int client_fd = -1;
 	struct sockaddr_in address;
-	socklen_t addrlen = sizeof(address);
 	int opt = 1;
 
 	server_fd = socket(AF_INET, SOCK_STREAM, 0);
@@ -37,12 +39,25 @@ int net_open_server(int port) {
 		return -1;
 	}
 
-	if (listen(server_fd, 1) < 0) {
+	if (listen(server_fd, backlog) < 0) {
 		perror("listen");
 		close(server_fd);
 		return -1;
 	}
 
+	return server_fd;
+}
+
+int net_open_server(int port) {
+	int server_fd = -1;
+	int client_fd = -1;
+	struct sockaddr_in address;
+	socklen_t addrlen = sizeof(address);
+
+	server_fd = net_listen(port, 1);
+	if (server_fd < 0)
+		return -1;
+
 	client_fd = accept(server_fd, (struct sockaddr *)&address, &addrlen);
 	if (client_fd < 0) {
 		perror("accept");
@@ -54,6 +69,13 @@ int net_open_server(int port) {
 	return client_fd;
 }
 
+int net_set_nonblocking(int fd) {
+	int flags = fcntl(fd, F_GETFL, 0);
+	if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+		return -1;
+	return 0;
+}
+
 int net_open_client(const char *ip, int port) {
 	int sockfd;
 	struct sockaddr_in serv_addr;
@@ -83,37 +105,135 @@ int net_open_client(const char *ip, int port) {
 	return sockfd;
 }
 
-int net_send_byte(int sockfd, unsigned char b) {
-	ssize_t n;
-	unsigned char buf[1];
-	buf[0] = b;
+void net_conn_init(NetConn *c, int fd) {
+	int one = 1;
 
-	for (;;) {
-		n = write(sockfd, buf, 1);
-		if (n == 1)
-			return 0;
-		if (n < 0) {
-			perror("write");
-			return -1;
+	memset(c, 0, sizeof(*c));
+	c->fd = fd;
+	// Frames are tiny and latency-bound: don't let Nagle hold them back
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+int net_encode(uint8_t *buf, int type, uint16_t seq, uint32_t hash, const void *payload, int len) {
+	if (len < 0 || len > NET_MAX_PAYLOAD)
+		return -1;
+
+	buf[0] = (uint8_t)(NET_HEADER - 1 + len);
+	buf[1] = NET_PROTO_VERSION;
+	buf[2] = (uint8_t)type;
+	buf[3] = (uint8_t)(seq >> 8);
+	buf[4] = (uint8_t)seq;
+	buf[5] = (uint8_t)(hash >> 24);
+	buf[6] = (uint8_t)(hash >> 16);
+	buf[7] = (uint8_t)(hash >> 8);
+	buf[8] = (uint8_t)hash;
+	if (len)
+		memcpy(buf + NET_HEADER, payload, (size_t)len);
+	return NET_HEADER + len;
+}
+
+int net_queue(NetConn *c, int type, uint32_t hash, const void *payload, int len) {
+	if (len < 0 || len > NET_MAX_PAYLOAD || c->out_len + NET_HEADER + len > NET_CONN_BUF)
+		return -1;
+
+	c->out_len += net_encode(c->out + c->out_len, type, c->send_seq, hash, payload, len);
+	c->send_seq++;
+	return 0;
+}
+
+int net_flush(NetConn *c) {
+	int sent = 0;
+
+	while (sent < c->out_len) {
+		ssize_t n = send(c->fd, c->out + sent, (size_t)(c->out_len - sent), MSG_NOSIGNAL);
+		if (n > 0) {
+			sent += (int)n;
+			continue;
 		}
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		return -1;
 	}
+
+	c->out_len -= sent;
+	memmove(c->out, c->out + sent, (size_t)c->out_len);
+	return c->out_len == 0;
 }
 
-int net_recv_byte(int sockfd, unsigned char *out) {
-	ssize_t n;
-	unsigned char buf[1];
+int net_send(NetConn *c, int type, uint32_t hash, const void *payload, int len) {
+	if (net_queue(c, type, hash, payload, len) != 0)
+		return -1;
+	return net_flush(c) == 1 ? 0 : -1;
+}
+
+int net_fill(NetConn *c) {
+	if (c->in_len == NET_CONN_BUF) {
+		errno = ENOBUFS;
+		return -1;
+	}
 
 	for (;;) {
-		n = read(sockfd, buf, 1);
-		if (n == 1) {
-			*out = buf[0];
-			return 0;
-		}
-		if (n == 0)
-			return -1;
-		if (n < 0) {
-			perror("read");
-			return -1;
-		}
+		ssize_t n = read(c->fd, c->in + c->in_len, (size_t)(NET_CONN_BUF - c->in_len));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n > 0)
+			c->in_len += (int)n;
+		return (int)n;
 	}
 }
+
+int net_sync_seq(NetConn *c) {
+	if (c->in_len < NET_HEADER)
+		return 0;
+	c->recv_seq = (uint16_t)(c->in[3] << 8 | c->in[4]);
+	return 1;
+}
+
+int net_next_frame(NetConn *c, NetFrame *f) {
+	if (c->in_len < 1)
+		return 0;
+
+	int len = c->in[0];
+	if (len < NET_HEADER - 1 || len > NET_HEADER - 1 + NET_MAX_PAYLOAD)
+		return -1;
+	if (c->in_len >= 2 && c->in[1] != NET_PROTO_VERSION)
+		return NET_ERR_VERSION;
+	if (c->in_len < len + 1)
+		return 0;
+
+	const uint8_t *p = c->in;
+	f->type = p[2];
+	f->seq  = (uint16_t)(p[3] << 8 | p[4]);
+	f->hash = (uint32_t)p[5] << 24 | (uint32_t)p[6] << 16 | (uint32_t)p[7] << 8 | p[8];
+	f->len  = (uint8_t)(len + 1 - NET_HEADER);
+	memcpy(f->payload, p + NET_HEADER, f->len);
+
+	c->in_len -= len + 1;
+	memmove(c->in, c->in + len + 1, (size_t)c->in_len);
+
+	if (f->seq != c->recv_seq)
+		return -1;
+	c->recv_seq++;
+	return 1;
+}
+
+int net_recv(NetConn *c, NetFrame *f) {
+	for (;;) {
+		int r = net_next_frame(c, f);
+		if (r != 0)
+			return r;
+		int n = net_fill(c);
+		if (n <= 0)
+			return n < 0 ? -1 : 0;
+	}
+}
+
+uint32_t net_state_hash(const Board *g) {
+	uint64_t h = g->playerA * 0x9E3779B97F4A7C15ULL ^ g->playerB * 0xC2B2AE3D27D4EB4FULL;
+	h ^= h >> 31;
+	h *= 0xBF58476D1CE4E5B9ULL;
+	h ^= h >> 29;
+	return (uint32_t)h;
+}
@@ -1,9 +1,103 @@
 #ifndef NET_H
 #define NET_H
 
+#include <stdint.h>
+
+#include "gamelogic.h"
+
+/* Wire protocol: length-prefixed binary frames.
+ *
+ *   len:1 | version:1 | type:1 | seq:2 | hash:4 | payload:0..NET_MAX_PAYLOAD
+ *
+ * len counts the bytes after itself; multi-byte fields are big-endian.
+ * seq numbers each sender's frames from 0, so a lost or repeated frame is
+ * caught. hash is net_state_hash() of the sender's board after the frame's
+ * action, and the receiver compares it with its own to detect a desync.
+ * Bump NET_PROTO_VERSION whenever the layout or the types change.
+ */
+
+#define NET_PROTO_VERSION 3
+#define NET_HEADER        9
+#define NET_MAX_PAYLOAD   48
+#define NET_CONN_BUF      128
+
+typedef enum {
+	NET_HELLO   = 1,   /* match server greeting, no payload */
+	NET_MATCH   = 2,   /* payload: your side ('A'/'B'), starting player */
+	NET_MOVE    = 3,   /* payload: 0-based column */
+	NET_UNDO    = 4,
+	NET_REDO    = 5,
+	NET_CHAT    = 6,   /* payload: quick chat index (spectators: + player) */
+	NET_RESIGN  = 7,   /* spectators: payload is the resigning player */
+	NET_QUERY   = 8,   /* connect4-botd: depth:1 | time_ms:2 | columns played */
+	NET_REPLY   = 9,   /* query seq:2 | status:1 | move:1 | depth:1 | flags:1 | us:4 */
+	NET_CATCHUP = 10   /* spectators: start | moves on board | every column in history */
+} NetFrameType;
+
+typedef struct {
+	uint8_t  type;
+	uint8_t  len;                       /* payload bytes */
+	uint16_t seq;
+	uint32_t hash;
+	uint8_t  payload[NET_MAX_PAYLOAD];
+} NetFrame;
+
+/* Buffered connection: one read() decodes every frame that has arrived,
+ * and queued frames go out together in one write(). */
+typedef struct {
+	int      fd;
+	uint16_t send_seq;
+	uint16_t recv_seq;
+	int      in_len;
+	int      out_len;
+	uint8_t  in[NET_CONN_BUF];
+	uint8_t  out[NET_CONN_BUF];
+} NetConn;
+
+#define NET_ERR_VERSION (-2)
+
 int net_open_server(int port);
+/* Listening socket on port (0 = any free port), kept open for accept. */
+int net_listen(int port, int backlog);
+int net_set_nonblocking(int fd);
 int net_open_client(const char *ip, int port);
-int net_send_byte(int sockfd, unsigned char b);
-int net_recv_byte(int sockfd, unsigned char *out);
+
+/* Takes over fd (sets TCP_NODELAY) with empty buffers and sequence 0. */
+void net_conn_init(NetConn *c, int fd);
+
+/* Writes one frame to buf (room for NET_HEADER + NET_MAX_PAYLOAD bytes):
+ * its size, or -1 if the payload is too long. For frames encoded once and
+ * sent to many sockets. */
+int net_encode(uint8_t *buf, int type, uint16_t seq, uint32_t hash, const void *payload, int len);
+
+/* Appends a frame to the output buffer: 0, or -1 if it doesn't fit. */
+int net_queue(NetConn *c, int type, uint32_t hash, const void *payload, int len);
+
+/* Writes queued frames: 1 when all are sent, 0 if a non-blocking socket
+ * is full (call again when writable), -1 on error. */
+int net_flush(NetConn *c);
+
+/* net_queue + net_flush, for blocking sockets: 0 or -1. */
+int net_send(NetConn *c, int type, uint32_t hash, const void *payload, int len);
+
+/* One read() into the input buffer: bytes read, 0 at end of stream, -1 on
+ * error (errno EAGAIN when a non-blocking socket has nothing). */
+int net_fill(NetConn *c);
+
+/* Decodes the next buffered frame: 1 if *f was filled, 0 if more bytes are
+ * needed, -1 for a malformed or out-of-sequence frame, NET_ERR_VERSION if
+ * the peer speaks another protocol version. */
+int net_next_frame(NetConn *c, NetFrame *f);
+
+/* For a stream joined midway (spectators): takes the sequence number of
+ * the first buffered frame as the expected one. 1, or 0 until its header
+ * has arrived. */
+int net_sync_seq(NetConn *c);
+
+/* Blocking receive: 1 with a frame, 0 at end of stream, < 0 on error. */
+int net_recv(NetConn *c, NetFrame *f);
+
+/* 32-bit hash of the stones on the board, for desync checks. */
+uint32_t net_state_hash(const Board *g);
 
 #endif
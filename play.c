@@ -1,19 +1,79 @@
 #include "ui.h"
 #include "controller.h"
+#include "input.h"
 
 #include <time.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
+// Bot level of a --bot-vs-bot side: 1 easy, 2 medium, 3 hard, 0 if unknown
+static int bot_level(const char* s, size_t len) {
+	static const char* names[] = { "easy", "medium", "hard" };
+	for (int i = 0; i < 3; i++) {
+		if (strlen(names[i]) == len && strncmp(s, names[i], len) == 0)
+			return i + 1;
+	}
+	return 0;
+}
+
 int main(int argc, char** argv) {
 	int use_anim = 1;
 	int anim_ms = 110;
+	int headless = 0;
+	int recording = 0;   // --record given: headless games are saved too
+	unsigned seed = (unsigned)time(NULL);
+	HeadlessOptions hl = { .games = 1, .first = 'A' };
 
-	if (argc > 1 && strcmp(argv[1], "--no-anim") == 0)
-		use_anim = 0;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--no-anim") == 0)
+			use_anim = 0;
+		else if (strcmp(argv[i], "--stats") == 0)
+			controller_set_stats(stderr);
+		else if (strcmp(argv[i], "--raw") == 0)
+			input_set_raw(1);
+		else if (strcmp(argv[i], "--no-record") == 0)
+			controller_set_record(NULL);
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			controller_set_record(argv[++i]);
+			recording = 1;
+		} else if (strcmp(argv[i], "--moves") == 0 && i + 1 < argc) {
+			hl.moves = argv[++i];
+			headless = 1;
+		} else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+			hl.script = argv[++i];
+			headless = 1;
+		} else if (strcmp(argv[i], "--bot-vs-bot") == 0) {
+			// Optional LEVEL:LEVEL, medium against medium by default
+			const char* colon = (i + 1 < argc) ? strchr(argv[i + 1], ':') : NULL;
+			hl.bot_a = hl.bot_b = 2;
+			if (colon) {
+				hl.bot_a = bot_level(argv[i + 1], (size_t)(colon - argv[i + 1]));
+				hl.bot_b = bot_level(colon + 1, strlen(colon + 1));
+				i++;
+				if (!hl.bot_a || !hl.bot_b) {
+					fprintf(stderr, "--bot-vs-bot takes easy|medium|hard:easy|medium|hard\n");
+					return 2;
+				}
+			}
+			headless = 1;
+		} else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc)
+			hl.games = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc)
+			hl.depth = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--first") == 0 && i + 1 < argc)
+			hl.first = (argv[++i][0] == 'B') ? 'B' : 'A';
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = (unsigned)strtoul(argv[++i], NULL, 10);
+	}
+
+	srand(seed);
 
-	srand((unsigned)time(NULL));
+	if (headless) {
+		if (!recording)
+			controller_set_record(NULL);
+		return run_headless(&hl, stdout);
+	}
 
 	while (1) {
 		int selection = ui_main_menu();
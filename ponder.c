@@ -0,0 +1,111 @@
+#define _POSIX_C_SOURCE 200112L
+#include "ponder.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+	pthread_t thread;
+	int       running;     // thread started and not joined yet
+	int       done;        // the search returned on its own
+	int       stop;        // cancel flag handed to pick_best_move
+	int       predicted;   // board is after the predicted reply
+	Board     board;       // position being searched
+	BotLimits limits;
+	long long start_ns;
+	long long end_ns;
+	int       move;
+	BotStats  stats;
+} PonderState;
+
+static PonderState ponder;
+
+static long long ponder_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void* ponder_main(void* arg) {
+	(void)arg;
+	ponder.move = pick_best_move(&ponder.board, &ponder.limits, &ponder.stats);
+	ponder.end_ns = ponder_now_ns();
+	__atomic_store_n(&ponder.done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+void ponder_start(const Board* g, const BotLimits* limits) {
+	ponder_stop();
+
+	ponder.board     = *g;
+	ponder.predicted = 0;
+
+	// Search the position after the expected reply, unless that reply
+	// already ends the game
+	int reply = bot_tt_move(g);
+	if (reply >= 0) {
+		Board next = *g;
+		game_drop(&next, reply, next.current);
+		if (!checkWin(&next, next.current) && !checkDraw(&next)) {
+			next.current     = (next.current == 'A') ? 'B' : 'A';
+			ponder.board     = next;
+			ponder.predicted = 1;
+		}
+	}
+
+	// No deadline: the search runs until it completes or ponder_stop()
+	ponder.limits           = limits ? *limits : (BotLimits){ 0 };
+	ponder.limits.time_ms   = 0;
+	ponder.limits.max_nodes = 0;
+	ponder.limits.stop      = &ponder.stop;
+
+	ponder.stop     = 0;
+	ponder.done     = 0;
+	ponder.start_ns = ponder_now_ns();
+	ponder.running  = (pthread_create(&ponder.thread, NULL, ponder_main, NULL) == 0);
+}
+
+void ponder_stop(void) {
+	if (!ponder.running) return;
+	__atomic_store_n(&ponder.stop, 1, __ATOMIC_RELAXED);
+	pthread_join(ponder.thread, NULL);
+	ponder.running = 0;
+	if (!ponder.done)
+		ponder.end_ns = ponder_now_ns();
+}
+
+static int same_position(const Board* a, const Board* b) {
+	return a->playerA == b->playerA && a->playerB == b->playerB && a->current == b->current;
+}
+
+int ponder_pick_move(Board* g, const BotLimits* limits, BotStats* stats) {
+	int was_running = ponder.running;
+	int done        = was_running && __atomic_load_n(&ponder.done, __ATOMIC_ACQUIRE);
+	ponder_stop();
+
+	int hit = was_running && ponder.predicted && same_position(&ponder.board, g) &&
+	          ponder.stats.depth > 0;
+	if (!hit)
+		return pick_best_move(g, limits, stats);
+
+	// The pondered search counts against the budget
+	long long spent_ms = (ponder.end_ns - ponder.start_ns) / 1000000LL;
+	int budget_ms = limits ? limits->time_ms : 0;
+	if (done || (budget_ms > 0 && spent_ms >= budget_ms)) {
+		if (stats) {
+			*stats = ponder.stats;
+			stats->ponder = 1;
+		}
+		return ponder.move;
+	}
+
+	// Not long enough yet: search again for the rest of the budget. The
+	// table is warm, so the earlier depths come back almost for free
+	BotLimits rest = limits ? *limits : (BotLimits){ 0 };
+	if (budget_ms > 0)
+		rest.time_ms = budget_ms - (int)spent_ms;
+	int move = pick_best_move(g, &rest, stats);
+	if (stats) stats->ponder = 1;
+	return move;
+}
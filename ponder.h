@@ -0,0 +1,29 @@
+#ifndef PONDER_H
+#define PONDER_H
+
+#pragma once
+
+#include "gamelogic.h"
+#include "bot.h"
+
+/* Pondering: the hard bot keeps searching on the opponent's time.
+ *
+ * After the bot moves, ponder_start() searches in a background thread the
+ * position after the reply the transposition table predicts (or, without a
+ * prediction, the opponent's position itself, which warms the table for
+ * every reply). ponder_pick_move() replaces pick_best_move() for the bot's
+ * next move: on a ponder hit that already used the time budget its move is
+ * played at once, on a shorter hit the search continues for the rest of the
+ * budget, and on a miss the bot searches normally with a warmer table.
+ */
+
+/* Starts pondering on g, the opponent to move. limits are the bot's own. */
+void ponder_start(const Board* g, const BotLimits* limits);
+
+/* Stops the background search and waits for it; harmless when idle. */
+void ponder_stop(void);
+
+/* Stops pondering and picks the bot's move for g as described above. */
+int ponder_pick_move(Board* g, const BotLimits* limits, BotStats* stats);
+
+#endif
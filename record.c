@@ -0,0 +1,141 @@
+#include "record.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(RecordHeader) == 32, "record header layout");
+_Static_assert(sizeof(GameRecord) == 32, "game record layout");
+
+void record_init(GameRecord* r, char start, int players) {
+	memset(r, 0, sizeof(*r));
+	r->start   = (uint8_t)start;
+	r->players = (uint8_t)players;
+}
+
+int record_push(GameRecord* r, int col) {
+	if (r->n_moves == ROWS * COLS || col < 0 || col >= COLS)
+		return -1;
+	int bit = 3 * r->n_moves++;
+	r->moves[bit >> 6] |= (uint64_t)col << (bit & 63);
+	if ((bit & 63) > 61)
+		r->moves[1] |= (uint64_t)col >> (64 - (bit & 63));
+	return 0;
+}
+
+int record_outcome(const Board* b) {
+	if (checkWin(b, 'A')) return RECORD_WIN_A;
+	if (checkWin(b, 'B')) return RECORD_WIN_B;
+	if (checkDraw(b))     return RECORD_DRAW;
+	return RECORD_UNFINISHED;
+}
+
+int record_replay(const GameRecord* r, Board* b) {
+	if (!record_ok(r))
+		return -1;
+
+	char side = (char)r->start;
+	int  n    = r->n_moves;
+
+	// Whole 64-bit words at a time: 21 moves, then the straddling one
+	uint64_t w = r->moves[0];
+	for (int i = 0; i < n; i++) {
+		int col;
+		if (i < 21) {
+			col = (int)(w & 7);
+			w >>= 3;
+		} else {
+			col = record_move(r, i);
+		}
+		if (col >= COLS || game_drop(b, col, side) == -1)
+			return -1;
+		// Only the last move may win
+		if (i + 1 < n && checkWin(b, side))
+			return -1;
+		side = (side == 'A') ? 'B' : 'A';
+	}
+	b->current = side;
+	return n;
+}
+
+FILE* record_append(const char* path) {
+	FILE* f = fopen(path, "a+b");
+	if (!f)
+		return NULL;
+
+	RecordHeader h;
+	if (fseek(f, 0, SEEK_END) == 0 && ftell(f) == 0) {
+		memset(&h, 0, sizeof h);
+		memcpy(h.magic, RECORD_FILE_MAGIC, 4);
+		h.version      = RECORD_FILE_VERSION;
+		h.record_bytes = sizeof(GameRecord);
+		if (fwrite(&h, sizeof h, 1, f) == 1 && fflush(f) == 0)
+			return f;
+	} else if (fseek(f, 0, SEEK_SET) == 0 && fread(&h, sizeof h, 1, f) == 1 &&
+	           memcmp(h.magic, RECORD_FILE_MAGIC, 4) == 0 &&
+	           h.version == RECORD_FILE_VERSION && h.record_bytes == sizeof(GameRecord)) {
+		// Cut a torn last record (a crash mid-write) so the next ones line
+		// up again; "a" mode writes at the end whatever the read position
+		struct stat st;
+		if (fstat(fileno(f), &st) == 0) {
+			off_t whole = (off_t)sizeof h +
+				(st.st_size - (off_t)sizeof h) / (off_t)sizeof(GameRecord) * (off_t)sizeof(GameRecord);
+			if (whole == st.st_size || ftruncate(fileno(f), whole) == 0)
+				return f;
+		}
+	}
+	fclose(f);
+	return NULL;
+}
+
+int record_write(FILE* f, const GameRecord* r) {
+	return fwrite(r, sizeof(*r), 1, f) == 1 ? 0 : -1;
+}
+
+int record_save(const char* path, const GameRecord* r) {
+	FILE* f = record_append(path);
+	if (!f)
+		return -1;
+	int ok = record_write(f, r) == 0;
+	return (fclose(f) == 0 && ok) ? 0 : -1;
+}
+
+int record_map(RecordFile* rf, const char* path) {
+	memset(rf, 0, sizeof(*rf));
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+
+	void* map = MAP_FAILED;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(RecordHeader))
+		map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return 0;
+
+	const RecordHeader* h = (const RecordHeader*)map;
+	if (memcmp(h->magic, RECORD_FILE_MAGIC, 4) != 0 || h->version != RECORD_FILE_VERSION ||
+	    h->record_bytes != sizeof(GameRecord)) {
+		munmap(map, (size_t)st.st_size);
+		return 0;
+	}
+
+	// Replay reads the records front to back
+	madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	rf->map     = map;
+	rf->bytes   = (size_t)st.st_size;
+	rf->records = (const GameRecord*)((const char*)map + sizeof(RecordHeader));
+	rf->count   = (rf->bytes - sizeof(RecordHeader)) / sizeof(GameRecord);
+	return 1;
+}
+
+void record_unmap(RecordFile* rf) {
+	if (rf->map)
+		munmap(rf->map, rf->bytes);
+	memset(rf, 0, sizeof(*rf));
+}
@@ -0,0 +1,114 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "gamelogic.h"
+
+/* Game records: a compact log of finished games.
+ *
+ * A record file is a RecordHeader followed by one 32-byte GameRecord per
+ * game, appended as games finish. Records have a fixed size, so game i
+ * sits at a known offset and a mapped file is indexed like an array.
+ *
+ * Moves take 3 bits each (the 0-based column), the first move in the low
+ * bits of moves[0] and carrying on into moves[1]: a full board of 42 moves
+ * uses 126 of the 128 bits. The rest of the record says who played (and
+ * with which hard-bot budget), who started and how the game ended.
+ */
+
+#define RECORD_FILE         "games.bin"
+#define RECORD_FILE_MAGIC   "C4GR"
+#define RECORD_FILE_VERSION 1
+
+typedef struct {
+	char     magic[4];
+	uint32_t version;
+	uint32_t record_bytes;
+	uint8_t  reserved[20];
+} RecordHeader;
+
+/* Outcome in the low bits of result; RECORD_RESIGNED when the loser
+ * resigned instead of being beaten on the board. */
+enum { RECORD_UNFINISHED = 0, RECORD_WIN_A = 1, RECORD_WIN_B = 2, RECORD_DRAW = 3 };
+enum { RECORD_OUTCOME = 3, RECORD_RESIGNED = 4 };
+
+/* Player kinds */
+enum { RECORD_HUMAN = 0, RECORD_REMOTE = 1, RECORD_RANDOM = 2, RECORD_MEDIUM = 3, RECORD_HARD = 4 };
+
+typedef struct {
+	uint8_t  n_moves;
+	uint8_t  result;
+	uint8_t  start;        /* 'A' or 'B' */
+	uint8_t  players;      /* kind of A | kind of B << 4 */
+	uint8_t  depth[2];     /* hard bots of A and B: max_depth (0 = default), */
+	uint8_t  eval[2];      /* BOT_EVAL_* */
+	uint16_t time_ms[2];   /* and time budget (0 = none) */
+	uint32_t finished;     /* Unix time the game ended, 0 = unknown */
+	uint64_t moves[2];
+} GameRecord;
+
+/* Empty record of a game that start opens; players as in GameRecord. */
+void record_init(GameRecord* r, char start, int players);
+
+/* Appends a move: 0, or -1 if the record is full or col is out of range. */
+int  record_push(GameRecord* r, int col);
+
+/* 1 if r can be read: no more moves than squares and a starting player.
+ * Records come straight from files, so check before reading the moves. */
+static inline int record_ok(const GameRecord* r) {
+	return r->n_moves <= ROWS * COLS && (r->start == 'A' || r->start == 'B');
+}
+
+/* 0-based column of move i, for i < n_moves of a record_ok record. */
+static inline int record_move(const GameRecord* r, int i) {
+	int bit = 3 * i;
+	uint64_t m = r->moves[bit >> 6] >> (bit & 63);
+	if ((bit & 63) > 61)
+		m |= r->moves[1] << (64 - (bit & 63));
+	return (int)(m & 7);
+}
+
+/* Outcome of the position on b: RECORD_WIN_A/B, RECORD_DRAW or
+ * RECORD_UNFINISHED. */
+int  record_outcome(const Board* b);
+
+/* Plays every move of r into b (an empty board with r's starting player).
+ * Returns the moves played, or -1 for a record that isn't record_ok, an
+ * illegal move or one after a win. */
+int  record_replay(const GameRecord* r, Board* b);
+
+/* Opens path for appending records, writing the header to a new file.
+ * A partly written last record is cut off first, so new records stay
+ * aligned. NULL on error or if path holds something else. */
+FILE* record_append(const char* path);
+int   record_write(FILE* f, const GameRecord* r);   /* 0 or -1 */
+
+/* record_append + record_write + fclose, for one game at a time. */
+int   record_save(const char* path, const GameRecord* r);
+
+/* A record file mapped read-only. */
+typedef struct {
+	void*             map;
+	size_t            bytes;
+	const GameRecord* records;
+	uint64_t          count;
+} RecordFile;
+
+/* 1 if path was mapped, 0 if missing or not a record file. A partly
+ * written last record is left out. */
+int  record_map(RecordFile* rf, const char* path);
+
+/* Record i of a mapped file, NULL if i is past the end or the record
+ * isn't record_ok. */
+static inline const GameRecord* record_at(const RecordFile* rf, uint64_t i) {
+	if (i >= rf->count || !record_ok(&rf->records[i]))
+		return NULL;
+	return &rf->records[i];
+}
+void record_unmap(RecordFile* rf);
+
+#endif
@@ -0,0 +1,232 @@
+// Game record replay.
+//
+//   ./connect4-replay [-r rounds] [FILE]
+//   ./connect4-replay --dump FILE [first [count]]
+//   ./connect4-replay --gen N FILE [-s seed]
+//
+// Maps a record file (record.h, default games.bin) and replays every game
+// into a Board with game_drop, checking that the moves are legal and that
+// the final position matches the recorded result. Prints games, moves and
+// results per pairing of player kinds, then records/s and moves/s of the
+// replay (the best of `rounds` passes, default 3). --dump prints records
+// from index `first` as 1-based move strings, which connect4-solve reads,
+// followed by the header fields. --gen appends N random games, a quick
+// way to build a corpus of millions to measure with.
+
+#define _POSIX_C_SOURCE 200112L
+#include "gamelogic.h"
+#include "record.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char* kind_names[] = { "human", "remote", "random", "medium", "hard" };
+
+#define N_KINDS (int)(sizeof kind_names / sizeof kind_names[0])
+
+static double now_sec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static const char* kind_name(int kind) {
+	return (kind >= 0 && kind < N_KINDS) ? kind_names[kind] : "?";
+}
+
+static const char* outcome_name(int result) {
+	switch (result & RECORD_OUTCOME) {
+	case RECORD_WIN_A: return (result & RECORD_RESIGNED) ? "A (resign)" : "A";
+	case RECORD_WIN_B: return (result & RECORD_RESIGNED) ? "B (resign)" : "B";
+	case RECORD_DRAW:  return "draw";
+	default:           return "unfinished";
+	}
+}
+
+// 1 if r replays legally to a position that agrees with its result
+static int replay_one(const GameRecord* r, unsigned long long* moves) {
+	if (!r)
+		return 0;
+	Board b;
+	initializeBoard(&b, (char)r->start);
+	int n = record_replay(r, &b);
+	if (n < 0)
+		return 0;
+	*moves += (unsigned)n;
+
+	int outcome = record_outcome(&b);
+	if (r->result & RECORD_RESIGNED)
+		return outcome == RECORD_UNFINISHED;
+	return outcome == (r->result & RECORD_OUTCOME);
+}
+
+static int run_replay(const char* path, int rounds) {
+	RecordFile rf;
+	if (!record_map(&rf, path)) {
+		fprintf(stderr, "replay: %s is not a record file\n", path);
+		return 1;
+	}
+
+	// Per pairing of kinds: unfinished, wins of A, wins of B, draws (by
+	// RECORD_OUTCOME), then all games
+	static unsigned long long table[N_KINDS][N_KINDS][5];
+	unsigned long long bad = 0, moves = 0;
+	double best = 0.0;
+
+	for (int round = 0; round < rounds; round++) {
+		unsigned long long round_bad = 0, round_moves = 0;
+		double t0 = now_sec();
+		for (uint64_t i = 0; i < rf.count; i++)
+			round_bad += !replay_one(record_at(&rf, i), &round_moves);
+		double t = now_sec() - t0;
+		if (round == 0 || t < best)
+			best = t;
+		bad   = round_bad;
+		moves = round_moves;
+	}
+
+	for (uint64_t i = 0; i < rf.count; i++) {
+		const GameRecord* r = record_at(&rf, i);
+		if (!r)
+			continue;
+		int a = r->players & 15, b = r->players >> 4;
+		if (a >= N_KINDS || b >= N_KINDS)
+			continue;
+		table[a][b][4]++;
+		table[a][b][r->result & RECORD_OUTCOME]++;
+	}
+
+	printf("%s: %llu games, %llu moves, %llu invalid (%zu bytes per game)\n", path,
+		(unsigned long long)rf.count, moves, bad, sizeof(GameRecord));
+	for (int a = 0; a < N_KINDS; a++) {
+		for (int b = 0; b < N_KINDS; b++) {
+			const unsigned long long* t = table[a][b];
+			if (!t[4]) continue;
+			printf("  %-7s vs %-7s %10llu games  A %5.1f%%  B %5.1f%%  draw %5.1f%%\n",
+				kind_name(a), kind_name(b), t[4],
+				100.0 * t[RECORD_WIN_A] / t[4], 100.0 * t[RECORD_WIN_B] / t[4],
+				100.0 * t[RECORD_DRAW] / t[4]);
+		}
+	}
+	printf("replay: %.3f s, %.2f M records/s, %.1f M moves/s\n", best,
+		best > 0 ? rf.count / best / 1e6 : 0.0, best > 0 ? moves / best / 1e6 : 0.0);
+
+	record_unmap(&rf);
+	return bad ? 1 : 0;
+}
+
+static int run_dump(const char* path, uint64_t first, uint64_t count) {
+	RecordFile rf;
+	if (!record_map(&rf, path)) {
+		fprintf(stderr, "replay: %s is not a record file\n", path);
+		return 1;
+	}
+
+	// <moves> <start> <result> <A kind> <B kind>, then hard-bot budgets
+	for (uint64_t i = first; i < rf.count && i - first < count; i++) {
+		const GameRecord* r = record_at(&rf, i);
+		if (!r) {
+			printf("- ? corrupt record %llu\n", (unsigned long long)i);
+			continue;
+		}
+		char moves[ROWS * COLS + 1];
+		for (int m = 0; m < r->n_moves; m++)
+			moves[m] = (char)('1' + record_move(r, m));
+		moves[r->n_moves] = '\0';
+
+		printf("%s %c %s %s %s", r->n_moves ? moves : "-", r->start, outcome_name(r->result),
+			kind_name(r->players & 15), kind_name(r->players >> 4));
+		for (int s = 0; s < 2; s++) {
+			if (((r->players >> (4 * s)) & 15) == RECORD_HARD)
+				printf(" %c:depth=%d,time=%d,eval=%d", 'A' + s, r->depth[s], r->time_ms[s], r->eval[s]);
+		}
+		printf("\n");
+	}
+
+	record_unmap(&rf);
+	return 0;
+}
+
+static int run_gen(const char* path, long n, unsigned seed) {
+	FILE* f = record_append(path);
+	if (!f) {
+		fprintf(stderr, "replay: cannot append to %s\n", path);
+		return 1;
+	}
+
+	double t0 = now_sec();
+	for (long g = 0; g < n; g++) {
+		GameRecord r;
+		Board      b;
+		char       start = (g & 1) ? 'B' : 'A';
+		initializeBoard(&b, start);
+		record_init(&r, start, RECORD_RANDOM | RECORD_RANDOM << 4);
+
+		int outcome = RECORD_UNFINISHED;
+		while (outcome == RECORD_UNFINISHED) {
+			int col = (int)(rand_r(&seed) % COLS);
+			if (game_drop(&b, col, b.current) == -1)
+				continue;
+			record_push(&r, col);
+			b.current = (b.current == 'A') ? 'B' : 'A';
+			outcome   = record_outcome(&b);
+		}
+		r.result = (uint8_t)outcome;
+		if (record_write(f, &r) != 0) {
+			fprintf(stderr, "replay: write error\n");
+			fclose(f);
+			return 1;
+		}
+	}
+	if (fclose(f) != 0) {
+		fprintf(stderr, "replay: write error\n");
+		return 1;
+	}
+	printf("Appended %ld random games to %s in %.2f s\n", n, path, now_sec() - t0);
+	return 0;
+}
+
+static void usage(const char* prog) {
+	fprintf(stderr, "usage: %s [-r rounds] [FILE]\n", prog);
+	fprintf(stderr, "       %s --dump FILE [first [count]]\n", prog);
+	fprintf(stderr, "       %s --gen N FILE [-s seed]\n", prog);
+}
+
+int main(int argc, char** argv) {
+	if (argc > 2 && strcmp(argv[1], "--dump") == 0) {
+		uint64_t first = (argc > 3) ? strtoull(argv[3], NULL, 10) : 0;
+		uint64_t count = (argc > 4) ? strtoull(argv[4], NULL, 10) : UINT64_MAX;
+		return run_dump(argv[2], first, count);
+	}
+	if (argc > 3 && strcmp(argv[1], "--gen") == 0) {
+		long     n    = atol(argv[2]);
+		unsigned seed = 1;
+		if (argc > 5 && strcmp(argv[4], "-s") == 0)
+			seed = (unsigned)strtoul(argv[5], NULL, 10);
+		if (n < 1) {
+			usage(argv[0]);
+			return 2;
+		}
+		return run_gen(argv[3], n, seed);
+	}
+
+	int         rounds = 3;
+	const char* path   = RECORD_FILE;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			rounds = atoi(argv[++i]);
+		} else if (argv[i][0] == '-') {
+			usage(argv[0]);
+			return 2;
+		} else {
+			path = argv[i];
+		}
+	}
+	if (rounds < 1) {
+		usage(argv[0]);
+		return 2;
+	}
+	return run_replay(path, rounds);
+}
@@ -0,0 +1,686 @@
+// Multi-match game server.
+//
+//   ./connect4-server [-p port] [-t threads]
+//   ./connect4-server --bench matches [-t threads]
+//
+// Keeps the listening socket open (default port 4444) and pairs players in
+// arrival order: the first of each pair plays A and starts. Clients are the
+// normal game in online "join" mode, speaking the framed protocol of
+// net.h. The acceptor owns the listener and the one waiting player; each full match is handed to one of `threads`
+// workers (default 2), which multiplex all their matches on an epoll
+// instance with non-blocking sockets. A match keeps its own board and
+// undo/redo history, checks every move, undo and redo (and the state hash
+// the client sends with it) against them, and relays them and chat to the
+// opponent. Frames relayed in one pass go out in one write. A protocol
+// error, a desync, a client too slow to read, or a hang-up counts as
+// resigning.
+//
+// Every 10 s the server prints accepted connections/s, live matches and
+// resident memory per match. --bench runs the server on a free port,
+// connects 2 * matches clients from this process, relays one move per
+// match and reports connections/s, moves/s and memory per match.
+
+#define _GNU_SOURCE
+#include "gamelogic.h"
+#include "history.h"
+#include "net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#define SERVER_PORT        4444
+#define SERVER_MAX_WORKERS 64
+#define SERVER_EVENTS      256
+#define SERVER_STATS_SEC   10
+
+typedef struct Match  Match;
+typedef struct Worker Worker;
+
+typedef struct {
+	NetConn net;        // net.fd is -1 once closed
+	char    side;
+	int     want_out;   // EPOLLOUT registered
+	Match*  match;
+} Conn;
+
+struct Match {
+	Conn    conn[2];   // conn[0] plays A
+	Board   board;
+	History history;
+	int     over;      // close both sides once their output drains
+	int     retired;
+	Worker* worker;
+	Match*  next_dead;
+};
+
+struct Worker {
+	pthread_t thread;
+	int       epfd;
+	int       inbox[2];     // pipe carrying Match* from the acceptor
+	Match*    dead;         // freed after the current epoll batch
+};
+
+typedef struct {
+	int     listen_fd;
+	Match*  pending;        // match whose A side waits for an opponent
+	int     epfd;
+	Worker* workers;
+	int     n_workers;
+	int     next_worker;
+	int     verbose;
+} Acceptor;
+
+static long long stat_accepted     = 0;
+static long long stat_matches      = 0;
+static long long stat_matches_live = 0;
+
+static double now_sec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static long long resident_bytes(void) {
+	long pages = 0, resident = 0;
+	FILE* f = fopen("/proc/self/statm", "r");
+	if (!f) return 0;
+	if (fscanf(f, "%ld %ld", &pages, &resident) != 2)
+		resident = 0;
+	fclose(f);
+	return (long long)resident * sysconf(_SC_PAGESIZE);
+}
+
+// Thousands of matches need more descriptors than the default soft limit
+static long raise_fd_limit(void) {
+	struct rlimit rl;
+	if (getrlimit(RLIMIT_NOFILE, &rl) != 0)
+		return 1024;
+	rl.rlim_cur = rl.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &rl);
+	getrlimit(RLIMIT_NOFILE, &rl);
+	return (long)rl.rlim_cur;
+}
+
+// ---------------------------------------------------------------------------
+// Connections (worker threads)
+// ---------------------------------------------------------------------------
+
+static void conn_close(Conn* c) {
+	if (c->net.fd < 0) return;
+	epoll_ctl(c->match->worker->epfd, EPOLL_CTL_DEL, c->net.fd, NULL);
+	close(c->net.fd);
+	c->net.fd      = -1;
+	c->net.out_len = 0;
+}
+
+static void conn_interest(Conn* c, int want_out) {
+	if (c->want_out == want_out) return;
+	struct epoll_event ev;
+	ev.events   = EPOLLIN | EPOLLRDHUP | (want_out ? EPOLLOUT : 0);
+	ev.data.ptr = c;
+	epoll_ctl(c->match->worker->epfd, EPOLL_CTL_MOD, c->net.fd, &ev);
+	c->want_out = want_out;
+}
+
+static void conn_flush(Conn* c) {
+	if (c->net.fd < 0) return;
+	int r = net_flush(&c->net);
+	if (r < 0)
+		conn_close(c);
+	else
+		conn_interest(c, r == 0);
+}
+
+static void match_forfeit(Match* m, int loser);
+
+// Queues a frame; conn_event flushes once everything is relayed
+static void conn_send(Conn* c, int type, const Board* b, const void* payload, int len) {
+	if (c->net.fd < 0) return;
+	if (net_queue(&c->net, type, net_state_hash(b), payload, len) != 0) {
+		// The client stopped reading: it loses the match
+		match_forfeit(c->match, (int)(c - c->match->conn));
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Matches
+// ---------------------------------------------------------------------------
+
+static void match_forfeit(Match* m, int loser) {
+	conn_close(&m->conn[loser]);
+	if (!m->over)
+		conn_send(&m->conn[1 - loser], NET_RESIGN, &m->board, NULL, 0);
+	m->over = 1;
+}
+
+// Applies one frame from player `me`; 0 on a protocol error or a desync
+static int match_action(Match* m, int me, const NetFrame* f) {
+	Conn* other = &m->conn[1 - me];
+	char  side  = m->conn[me].side;
+
+	if (m->over)
+		return 1;
+	if (f->type == NET_CHAT) {
+		conn_send(other, NET_CHAT, &m->board, f->payload, f->len);
+		return 1;
+	}
+	if (f->type == NET_RESIGN) {
+		m->over = 1;
+		conn_send(other, NET_RESIGN, &m->board, NULL, 0);
+		return 1;
+	}
+	if (side != m->board.current)
+		return 0;
+
+	if (f->type == NET_MOVE && f->len == 1 && f->payload[0] < COLS) {
+		int col = f->payload[0];
+		int row = game_drop(&m->board, col, side);
+		if (row == -1 || f->hash != net_state_hash(&m->board))
+			return 0;
+		history_record_move(&m->history, row, col, side);
+		if (checkWin(&m->board, side) || checkDraw(&m->board))
+			m->over = 1;
+		else
+			m->board.current = other->side;
+		conn_send(other, NET_MOVE, &m->board, f->payload, 1);
+		return 1;
+	}
+	if (f->type == NET_UNDO && history_undo(&m->history, &m->board, 1)) {
+		conn_send(other, NET_UNDO, &m->board, NULL, 0);
+		return f->hash == net_state_hash(&m->board);
+	}
+	if (f->type == NET_REDO && history_redo(&m->history, &m->board, 1)) {
+		conn_send(other, NET_REDO, &m->board, NULL, 0);
+		return f->hash == net_state_hash(&m->board);
+	}
+	return 0;
+}
+
+// Closes drained sides of a finished match and retires it when both are gone
+static void match_reap(Match* m) {
+	for (int i = 0; i < 2; i++)
+		conn_flush(&m->conn[i]);
+	if (m->over) {
+		for (int i = 0; i < 2; i++) {
+			if (m->conn[i].net.out_len == 0)
+				conn_close(&m->conn[i]);
+		}
+	}
+	if (m->retired || m->conn[0].net.fd >= 0 || m->conn[1].net.fd >= 0)
+		return;
+	m->retired      = 1;
+	m->next_dead    = m->worker->dead;
+	m->worker->dead = m;
+	__atomic_sub_fetch(&stat_matches_live, 1, __ATOMIC_RELAXED);
+}
+
+// One read, then every complete frame in the buffer
+static void conn_read(Conn* c) {
+	Match*   m  = c->match;
+	int      me = (int)(c - m->conn);
+	NetFrame f;
+
+	int n = net_fill(&c->net);
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return;
+	if (n <= 0) {
+		match_forfeit(m, me);
+		return;
+	}
+
+	int r;
+	while ((r = net_next_frame(&c->net, &f)) == 1) {
+		if (!match_action(m, me, &f)) {
+			match_forfeit(m, me);
+			return;
+		}
+	}
+	if (r < 0)
+		match_forfeit(m, me);
+}
+
+static void conn_event(Conn* c, uint32_t events) {
+	Match* m = c->match;
+	if (c->net.fd >= 0 && (events & EPOLLOUT))
+		conn_flush(c);
+	if (c->net.fd >= 0 && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+		conn_read(c);
+	match_reap(m);
+}
+
+// New matches from the acceptor: register both sides and tell them their
+// colour. Returns 0 when asked to stop (a NULL match).
+static int worker_adopt(Worker* w) {
+	Match* batch[64];
+	ssize_t n = read(w->inbox[0], batch, sizeof batch);
+	if (n <= 0)
+		return 1;
+
+	for (size_t i = 0; i < (size_t)n / sizeof(Match*); i++) {
+		Match* m = batch[i];
+		if (!m)
+			return 0;
+		m->worker = w;
+		for (int s = 0; s < 2; s++) {
+			Conn* c = &m->conn[s];
+			struct epoll_event ev;
+			ev.events   = EPOLLIN | EPOLLRDHUP;
+			ev.data.ptr = c;
+			if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, c->net.fd, &ev) != 0) {
+				close(c->net.fd);
+				c->net.fd = -1;
+			}
+		}
+		for (int s = 0; s < 2; s++) {
+			uint8_t setup[2] = { (uint8_t)m->conn[s].side, (uint8_t)m->board.current };
+			conn_send(&m->conn[s], NET_MATCH, &m->board, setup, 2);
+		}
+		for (int s = 0; s < 2; s++) {
+			if (m->conn[s].net.fd < 0)
+				match_forfeit(m, s);
+		}
+		match_reap(m);
+	}
+	return 1;
+}
+
+static void* worker_main(void* arg) {
+	Worker* w = arg;
+	struct epoll_event events[SERVER_EVENTS];
+	int running = 1;
+
+	while (running) {
+		int n = epoll_wait(w->epfd, events, SERVER_EVENTS, -1);
+		for (int i = 0; i < n; i++) {
+			if (events[i].data.ptr == NULL)
+				running = worker_adopt(w) && running;
+			else
+				conn_event(events[i].data.ptr, events[i].events);
+		}
+		// Events of this batch may still point into retired matches
+		while (w->dead) {
+			Match* m = w->dead;
+			w->dead  = m->next_dead;
+			free(m);
+		}
+	}
+	return NULL;
+}
+
+static int worker_start(Worker* w) {
+	memset(w, 0, sizeof *w);
+	w->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (w->epfd < 0 || pipe(w->inbox) != 0)
+		return 0;
+	net_set_nonblocking(w->inbox[0]);
+
+	struct epoll_event ev;
+	ev.events   = EPOLLIN;
+	ev.data.ptr = NULL;
+	if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->inbox[0], &ev) != 0)
+		return 0;
+	return pthread_create(&w->thread, NULL, worker_main, w) == 0;
+}
+
+static void worker_stop(Worker* w) {
+	Match* none = NULL;
+	if (write(w->inbox[1], &none, sizeof none) == (ssize_t)sizeof none)
+		pthread_join(w->thread, NULL);
+	close(w->inbox[0]);
+	close(w->inbox[1]);
+	close(w->epfd);
+}
+
+// ---------------------------------------------------------------------------
+// Acceptor: pairs players and hands matches to the workers
+// ---------------------------------------------------------------------------
+
+static Match* match_new(void) {
+	Match* m = calloc(1, sizeof(Match));
+	if (!m) return NULL;
+	m->conn[0].net.fd = m->conn[1].net.fd = -1;
+	m->conn[0].side   = 'A';
+	m->conn[1].side   = 'B';
+	initializeBoard(&m->board, 'A');
+	history_reset(&m->history);
+	return m;
+}
+
+static void acceptor_drop_pending(Acceptor* a) {
+	epoll_ctl(a->epfd, EPOLL_CTL_DEL, a->pending->conn[0].net.fd, NULL);
+	close(a->pending->conn[0].net.fd);
+	free(a->pending);
+	a->pending = NULL;
+}
+
+// Greets fd and seats it: as A in a new match, or as B completing the
+// pending one, which then goes to the next worker
+static void acceptor_pair(Acceptor* a, int fd) {
+	Match* m = a->pending ? a->pending : match_new();
+	if (!m) {
+		close(fd);
+		return;
+	}
+	int   seat = a->pending ? 1 : 0;
+	Conn* c    = &m->conn[seat];
+	net_conn_init(&c->net, fd);
+	c->match = m;
+
+	if (net_queue(&c->net, NET_HELLO, 0, NULL, 0) != 0 || net_flush(&c->net) != 1) {
+		close(fd);
+		c->net.fd = -1;
+		if (!seat) free(m);
+		return;
+	}
+
+	if (!seat) {
+		struct epoll_event ev;
+		ev.events  = EPOLLIN | EPOLLRDHUP;
+		ev.data.fd = fd;
+		if (epoll_ctl(a->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+			close(fd);
+			free(m);
+			return;
+		}
+		a->pending = m;
+		return;
+	}
+
+	epoll_ctl(a->epfd, EPOLL_CTL_DEL, m->conn[0].net.fd, NULL);
+	a->pending = NULL;
+
+	__atomic_add_fetch(&stat_matches, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&stat_matches_live, 1, __ATOMIC_RELAXED);
+
+	Worker* w = &a->workers[a->next_worker];
+	a->next_worker = (a->next_worker + 1) % a->n_workers;
+	if (write(w->inbox[1], &m, sizeof m) != (ssize_t)sizeof m) {
+		close(m->conn[0].net.fd);
+		close(m->conn[1].net.fd);
+		free(m);
+		__atomic_sub_fetch(&stat_matches_live, 1, __ATOMIC_RELAXED);
+	}
+}
+
+static void acceptor_accept(Acceptor* a) {
+	for (;;) {
+		int fd = accept4(a->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				perror("accept");
+			return;
+		}
+		__atomic_add_fetch(&stat_accepted, 1, __ATOMIC_RELAXED);
+		acceptor_pair(a, fd);
+	}
+}
+
+static void acceptor_print_stats(long long accepted, double seconds) {
+	long long live  = __atomic_load_n(&stat_matches_live, __ATOMIC_RELAXED);
+	long long total = __atomic_load_n(&stat_matches, __ATOMIC_RELAXED);
+	long long rss   = resident_bytes();
+	fprintf(stderr, "server: %.0f conn/s, %lld live matches (%lld total), RSS %.1f MB",
+		seconds > 0 ? accepted / seconds : 0.0, live, total, rss / 1e6);
+	if (live > 0)
+		fprintf(stderr, " (%.0f B/match)", (double)rss / live);
+	fprintf(stderr, "\n");
+}
+
+// Runs until *stop is set (checked at least once a second)
+static void acceptor_run(Acceptor* a, const int* stop) {
+	struct epoll_event events[16];
+	double    last     = now_sec();
+	long long last_acc = 0;
+
+	while (!__atomic_load_n(stop, __ATOMIC_ACQUIRE)) {
+		int n = epoll_wait(a->epfd, events, 16, 1000);
+		for (int i = 0; i < n; i++) {
+			if (events[i].data.fd == a->listen_fd) {
+				acceptor_accept(a);
+			} else if (a->pending && events[i].data.fd == a->pending->conn[0].net.fd) {
+				// The lone waiting player left (or talked before its match)
+				acceptor_drop_pending(a);
+			}
+		}
+
+		double now = now_sec();
+		if (a->verbose && now - last >= SERVER_STATS_SEC) {
+			long long acc = __atomic_load_n(&stat_accepted, __ATOMIC_RELAXED);
+			acceptor_print_stats(acc - last_acc, now - last);
+			last     = now;
+			last_acc = acc;
+		}
+	}
+}
+
+static int server_start(Acceptor* a, Worker* workers, int n_workers, int port) {
+	memset(a, 0, sizeof *a);
+	a->workers    = workers;
+	a->n_workers  = n_workers;
+
+	a->listen_fd = net_listen(port, SOMAXCONN);
+	if (a->listen_fd < 0 || net_set_nonblocking(a->listen_fd) != 0)
+		return 0;
+
+	a->epfd = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event ev;
+	ev.events  = EPOLLIN;
+	ev.data.fd = a->listen_fd;
+	if (a->epfd < 0 || epoll_ctl(a->epfd, EPOLL_CTL_ADD, a->listen_fd, &ev) != 0)
+		return 0;
+
+	for (int i = 0; i < n_workers; i++) {
+		if (!worker_start(&workers[i])) {
+			perror("worker");
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void server_stop(Acceptor* a) {
+	for (int i = 0; i < a->n_workers; i++)
+		worker_stop(&a->workers[i]);
+	if (a->pending)
+		acceptor_drop_pending(a);
+	close(a->listen_fd);
+	close(a->epfd);
+}
+
+// ---------------------------------------------------------------------------
+// --bench: load from this process against an in-process server
+// ---------------------------------------------------------------------------
+
+typedef struct {
+	Acceptor* acceptor;
+	int       stop;
+} AcceptorThread;
+
+static void* acceptor_thread_main(void* arg) {
+	AcceptorThread* t = arg;
+	acceptor_run(t->acceptor, &t->stop);
+	return NULL;
+}
+
+static int read_full(int fd, uint8_t* buf, int n) {
+	int got = 0;
+	while (got < n) {
+		ssize_t r = read(fd, buf + got, (size_t)(n - got));
+		if (r < 0 && errno == EINTR) continue;
+		if (r <= 0) return 0;
+		got += (int)r;
+	}
+	return 1;
+}
+
+// Bench clients keep only their descriptor, so that RSS reflects the
+// server. They read exactly one frame at a time (never a byte of the next)
+// and decode it with a NetConn set to the sequence number reached.
+static int bench_recv(int fd, uint16_t seq, NetFrame* f) {
+	NetConn c;
+	net_conn_init(&c, fd);
+	c.recv_seq = seq;
+	if (!read_full(fd, c.in, 1) || c.in[0] > NET_HEADER - 1 + NET_MAX_PAYLOAD ||
+	    !read_full(fd, c.in + 1, c.in[0]))
+		return 0;
+	c.in_len = 1 + c.in[0];
+	return net_next_frame(&c, f) == 1;
+}
+
+static int run_bench(int matches, int n_workers) {
+	// Each match holds four descriptors here: two clients, two server sides
+	long limit = raise_fd_limit();
+	if ((long)matches * 4 + 64 > limit) {
+		matches = (int)((limit - 64) / 4);
+		fprintf(stderr, "server: descriptor limit %ld, benchmarking %d matches\n", limit, matches);
+	}
+	if (matches < 1)
+		return 1;
+
+	Acceptor a;
+	Worker   workers[SERVER_MAX_WORKERS];
+	if (!server_start(&a, workers, n_workers, 0))
+		return 1;
+
+	struct sockaddr_in addr;
+	socklen_t len = sizeof addr;
+	getsockname(a.listen_fd, (struct sockaddr*)&addr, &len);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	AcceptorThread at = { &a, 0 };
+	pthread_t thread;
+	pthread_create(&thread, NULL, acceptor_thread_main, &at);
+
+	int   n_clients = 2 * matches;
+	int*  clients   = malloc((size_t)n_clients * sizeof(int));
+	char* sides     = malloc((size_t)n_clients);
+	if (!clients || !sides) {
+		fprintf(stderr, "server: out of memory\n");
+		return 1;
+	}
+
+	long long rss_before = resident_bytes();
+	double    t0         = now_sec();
+	int       failed     = 0;
+
+	for (int i = 0; i < n_clients; i++) {
+		clients[i] = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (clients[i] < 0 || connect(clients[i], (struct sockaddr*)&addr, sizeof addr) != 0) {
+			perror("connect");
+			return 1;
+		}
+	}
+	for (int i = 0; i < n_clients; i++) {
+		NetFrame f;
+		sides[i] = 0;
+		if (!bench_recv(clients[i], 0, &f) || f.type != NET_HELLO ||
+		    !bench_recv(clients[i], 1, &f) || f.type != NET_MATCH) {
+			failed++;
+			continue;
+		}
+		sides[i] = (char)f.payload[0];
+	}
+	double    t1        = now_sec();
+	long long rss_after = resident_bytes();
+
+	// Every A opens with the centre column; every B must see it
+	Board   after;
+	uint8_t centre = 3;
+	initializeBoard(&after, 'A');
+	game_drop(&after, centre, 'A');
+
+	for (int i = 0; i < n_clients; i++) {
+		NetConn c;
+		net_conn_init(&c, clients[i]);
+		if (sides[i] == 'A' && net_send(&c, NET_MOVE, net_state_hash(&after), &centre, 1) != 0)
+			failed++;
+	}
+	for (int i = 0; i < n_clients; i++) {
+		NetFrame f;
+		if (sides[i] == 'B' && (!bench_recv(clients[i], 2, &f) || f.type != NET_MOVE ||
+		                        f.payload[0] != centre || f.hash != net_state_hash(&after)))
+			failed++;
+	}
+	double t2 = now_sec();
+
+	for (int i = 0; i < n_clients; i++)
+		close(clients[i]);
+	for (int i = 0; i < 500 && __atomic_load_n(&stat_matches_live, __ATOMIC_RELAXED) > 0; i++)
+		usleep(10000);
+
+	__atomic_store_n(&at.stop, 1, __ATOMIC_RELEASE);
+	pthread_join(thread, NULL);
+	server_stop(&a);
+
+	printf("Server bench: %d matches, %d worker threads\n", matches, n_workers);
+	printf("  connect + pair : %8.0f conn/s  (%d connections in %.3f s)\n",
+		n_clients / (t1 - t0), n_clients, t1 - t0);
+	printf("  relay          : %8.0f moves/s\n", matches / (t2 - t1));
+	printf("  memory         : %zu B per Match struct, %.0f B RSS per match\n",
+		sizeof(Match), (double)(rss_after - rss_before) / matches);
+	printf("  (RSS counts this process only: kernel socket buffers are extra)\n");
+	if (failed)
+		printf("  %d clients failed\n", failed);
+
+	free(clients);
+	free(sides);
+	return failed ? 1 : 0;
+}
+
+static void usage(const char* prog) {
+	fprintf(stderr, "usage: %s [-p port] [-t threads]\n", prog);
+	fprintf(stderr, "       %s --bench matches [-t threads]\n", prog);
+}
+
+int main(int argc, char** argv) {
+	int port    = SERVER_PORT;
+	int threads = 2;
+	int bench   = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			port = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+			bench = atoi(argv[++i]);
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if (threads < 1 || threads > SERVER_MAX_WORKERS || port < 0 || port > 65535 || bench < 0) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+	if (bench)
+		return run_bench(bench, threads);
+
+	raise_fd_limit();
+	Acceptor a;
+	Worker   workers[SERVER_MAX_WORKERS];
+	if (!server_start(&a, workers, threads, port))
+		return 1;
+	a.verbose = 1;
+	fprintf(stderr, "server: listening on port %d with %d worker threads\n", port, threads);
+
+	int stop = 0;
+	acceptor_run(&a, &stop);
+	server_stop(&a);
+	return 0;
+}
@@ -0,0 +1,168 @@
+// Batch position solver.
+//
+//   ./connect4-solve [-w] [-j threads] [file]
+//
+// Reads one position per line from `file` (default stdin), written as
+// 1-based column sequences like "4453", and prints
+//
+//   <moves> <score> <best column> <nodes> <microseconds>
+//
+// in input order. The score is the strong solver score (-w: weak, -1/0/1)
+// for the side to move; the best column is "-" on a full board. Positions
+// that are illegal or already decided print "<moves> invalid", as does a
+// line too long to be a position (its moves cut short and ended by "...").
+// Lines are read in batches that the OpenMP workers
+// solve in parallel against one shared transposition table; the totals and
+// positions/s go to stderr at the end.
+
+#define _POSIX_C_SOURCE 200809L
+#include "gamelogic.h"
+#include "bot.h"
+#include "tt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define SOLVE_BATCH 256
+#define SOLVE_LINE  128
+
+typedef struct {
+	char        moves[SOLVE_LINE];
+	int         too_long;   // moves holds a shortened copy: invalid
+	int         valid;
+	SolveResult result;
+} SolveJob;
+
+static double now_sec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Strips the line ending and surrounding blanks in place
+static char* trim(char* s) {
+	while (*s == ' ' || *s == '\t')
+		s++;
+	size_t n = strlen(s);
+	while (n && (s[n - 1] == '\n' || s[n - 1] == '\r' || s[n - 1] == ' ' || s[n - 1] == '\t'))
+		s[--n] = '\0';
+	return s;
+}
+
+static void solve_job(SolveJob* job, SolveMode mode) {
+	Board b;
+	initializeBoard(&b, 'A');
+	job->valid = !job->too_long && game_play_moves(&b, job->moves) >= 0 &&
+	             !checkWin(&b, 'A') && !checkWin(&b, 'B');
+	if (job->valid)
+		solve_position(&b, mode, &job->result);
+}
+
+static void usage(const char* prog) {
+	fprintf(stderr, "usage: %s [-w] [-j threads] [file]\n", prog);
+}
+
+int main(int argc, char** argv) {
+	SolveMode   mode    = SOLVE_STRONG;
+	int         threads = 0;
+	const char* path    = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-w") == 0) {
+			mode = SOLVE_WEAK;
+		} else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		} else if (argv[i][0] == '-' && argv[i][1]) {
+			usage(argv[0]);
+			return 2;
+		} else {
+			path = argv[i];
+		}
+	}
+
+	FILE* in = stdin;
+	if (path && strcmp(path, "-") != 0) {
+		in = fopen(path, "r");
+		if (!in) {
+			perror(path);
+			return 1;
+		}
+	}
+
+#ifdef _OPENMP
+	if (threads > 0)
+		omp_set_num_threads(threads);
+#else
+	(void)threads;
+#endif
+
+	// One table for all workers: positions from the same game share subtrees
+	zobrist_init();
+	tt_open(NULL);
+
+	static SolveJob jobs[SOLVE_BATCH];
+	char*  line = NULL;
+	size_t size = 0;
+	unsigned long long solved = 0, invalid = 0, total_nodes = 0;
+	double start = now_sec();
+	int eof = 0;
+
+	while (!eof) {
+		int n = 0;
+		while (n < SOLVE_BATCH) {
+			if (getline(&line, &size, in) == -1) {
+				eof = 1;
+				break;
+			}
+			char* moves = trim(line);
+			if (!*moves || *moves == '#')
+				continue;
+			SolveJob* job = &jobs[n++];
+			job->too_long = strlen(moves) >= sizeof job->moves;
+			if (job->too_long)
+				snprintf(job->moves, sizeof job->moves, "%.*s...",
+					(int)sizeof job->moves - 4, moves);
+			else
+				memcpy(job->moves, moves, strlen(moves) + 1);
+		}
+
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int i = 0; i < n; i++)
+			solve_job(&jobs[i], mode);
+
+		for (int i = 0; i < n; i++) {
+			const SolveJob* job = &jobs[i];
+			if (!job->valid) {
+				printf("%s invalid\n", job->moves);
+				invalid++;
+				continue;
+			}
+			char best[12] = "-";
+			if (job->result.best_move >= 0)
+				snprintf(best, sizeof best, "%d", job->result.best_move + 1);
+			printf("%s %d %s %llu %lld\n", job->moves, job->result.score, best,
+				job->result.stats.nodes, job->result.stats.elapsed_ns / 1000);
+			solved++;
+			total_nodes += job->result.stats.nodes;
+		}
+		fflush(stdout);
+	}
+
+	double elapsed = now_sec() - start;
+	fprintf(stderr, "solved %llu positions (%llu invalid) in %.3f s: %.1f positions/s, %.0f knodes/s\n",
+		solved, invalid, elapsed,
+		elapsed > 0 ? solved / elapsed : 0.0,
+		elapsed > 0 ? total_nodes / elapsed / 1e3 : 0.0);
+
+	free(line);
+	if (in != stdin)
+		fclose(in);
+	tt_free();
+	return 0;
+}
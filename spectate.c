@@ -0,0 +1,276 @@
+#define _GNU_SOURCE
+#include "spectate.h"
+
+#include "event.h"
+#include "net.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+// One encoded frame, shared by every queue it is on
+typedef struct {
+	int     refs;
+	int     len;
+	uint8_t data[NET_HEADER + NET_MAX_PAYLOAD];
+} Chunk;
+
+typedef struct {
+	int    fd;         // -1 = free slot
+	int    head;
+	int    count;
+	int    offset;     // bytes of queue[head] already sent
+	int    want_out;   // EPOLLOUT registered
+	Chunk* queue[SPECTATE_BACKLOG];
+} Watcher;
+
+static int            listen_fd = -1;
+static int            epfd      = -1;
+static const Board*   game_board;
+static const History* game_history;
+static char           game_start;
+static uint16_t       stream_seq;   // next frame of the shared stream
+
+static Watcher watchers[SPECTATE_MAX_WATCHERS];
+static int     n_watchers = 0;
+
+static Chunk* chunk_new(int type, uint16_t seq, const void* payload, int len) {
+	Chunk* c = malloc(sizeof(Chunk));
+	if (!c) return NULL;
+	c->refs = 1;
+	c->len  = net_encode(c->data, type, seq, net_state_hash(game_board), payload, len);
+	if (c->len < 0) {
+		free(c);
+		return NULL;
+	}
+	return c;
+}
+
+static void chunk_unref(Chunk* c) {
+	if (--c->refs == 0)
+		free(c);
+}
+
+static void watcher_drop(Watcher* w) {
+	epoll_ctl(epfd, EPOLL_CTL_DEL, w->fd, NULL);
+	close(w->fd);
+	while (w->count) {
+		chunk_unref(w->queue[w->head]);
+		w->head = (w->head + 1) % SPECTATE_BACKLOG;
+		w->count--;
+	}
+	w->fd = -1;
+	n_watchers--;
+}
+
+static void watcher_interest(Watcher* w, int want_out) {
+	if (w->want_out == want_out) return;
+	struct epoll_event ev;
+	ev.events   = EPOLLIN | EPOLLRDHUP | (want_out ? EPOLLOUT : 0);
+	ev.data.u32 = (uint32_t)(w - watchers) + 1;
+	epoll_ctl(epfd, EPOLL_CTL_MOD, w->fd, &ev);
+	w->want_out = want_out;
+}
+
+// Sends as much of the queue as the socket takes, in one sendmsg
+static void watcher_flush(Watcher* w) {
+	while (w->count) {
+		struct iovec iov[SPECTATE_BACKLOG];
+		for (int i = 0; i < w->count; i++) {
+			Chunk* c    = w->queue[(w->head + i) % SPECTATE_BACKLOG];
+			int    skip = i ? 0 : w->offset;
+			iov[i].iov_base = c->data + skip;
+			iov[i].iov_len  = (size_t)(c->len - skip);
+		}
+		struct msghdr msg;
+		memset(&msg, 0, sizeof msg);
+		msg.msg_iov    = iov;
+		msg.msg_iovlen = (size_t)w->count;
+
+		ssize_t n = sendmsg(w->fd, &msg, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (n <= 0) {
+			watcher_drop(w);
+			return;
+		}
+		while (n > 0) {
+			Chunk* c    = w->queue[w->head];
+			int    left = c->len - w->offset;
+			if (n < left) {
+				w->offset += (int)n;
+				break;
+			}
+			n        -= left;
+			w->offset = 0;
+			chunk_unref(c);
+			w->head = (w->head + 1) % SPECTATE_BACKLOG;
+			w->count--;
+		}
+	}
+	watcher_interest(w, w->count > 0);
+}
+
+// Queues c for w and sends what fits; a watcher too far behind is dropped
+static void watcher_push(Watcher* w, Chunk* c) {
+	if (w->count == SPECTATE_BACKLOG) {
+		watcher_drop(w);
+		return;
+	}
+	c->refs++;
+	w->queue[(w->head + w->count++) % SPECTATE_BACKLOG] = c;
+	watcher_flush(w);
+}
+
+// The game so far in one frame: starting player, moves on the board, then
+// every column in the history, including moves that can still be redone.
+// It takes the sequence number just before the next stream frame.
+static Chunk* catchup_chunk(void) {
+	uint8_t payload[2 + MAX_MOVES];
+	payload[0] = (uint8_t)game_start;
+	payload[1] = (uint8_t)game_history->current_index;
+	for (int i = 0; i < game_history->move_count; i++)
+		payload[2 + i] = (uint8_t)game_history->moves[i].col;
+	return chunk_new(NET_CATCHUP, (uint16_t)(stream_seq - 1), payload,
+		2 + game_history->move_count);
+}
+
+static void spectate_accept(void) {
+	for (;;) {
+		int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			return;
+		}
+
+		Watcher* w = NULL;
+		for (int i = 0; i < SPECTATE_MAX_WATCHERS && !w; i++) {
+			if (watchers[i].fd < 0)
+				w = &watchers[i];
+		}
+		struct epoll_event ev;
+		ev.events   = EPOLLIN | EPOLLRDHUP;
+		ev.data.u32 = w ? (uint32_t)(w - watchers) + 1 : 0;
+		Chunk* c    = w ? catchup_chunk() : NULL;
+		if (!c || epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+			if (c) chunk_unref(c);
+			close(fd);
+			continue;
+		}
+
+		int one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+		memset(w, 0, sizeof *w);
+		w->fd = fd;
+		n_watchers++;
+		watcher_push(w, c);
+		chunk_unref(c);
+	}
+}
+
+// Watchers only listen: anything they send is discarded
+static void watcher_read(Watcher* w) {
+	char buf[256];
+	for (;;) {
+		ssize_t n = read(w->fd, buf, sizeof buf);
+		if (n > 0)
+			continue;
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return;
+		watcher_drop(w);
+		return;
+	}
+}
+
+static void on_spectate_event(int fd, void* ctx) {
+	(void)ctx;
+	struct epoll_event events[64];
+	int n = epoll_wait(fd, events, 64, 0);
+	for (int i = 0; i < n; i++) {
+		uint32_t id = events[i].data.u32;
+		if (id == 0) {
+			spectate_accept();
+			continue;
+		}
+		Watcher* w = &watchers[id - 1];
+		if (w->fd >= 0 && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+			watcher_read(w);
+		if (w->fd >= 0 && (events[i].events & EPOLLOUT))
+			watcher_flush(w);
+	}
+}
+
+int spectate_open(int port, const Board* G, const History* H, char start) {
+	if (listen_fd >= 0)
+		spectate_close();
+
+	listen_fd = net_listen(port, 16);
+	if (listen_fd < 0)
+		return -1;
+	epfd = epoll_create1(EPOLL_CLOEXEC);
+
+	struct epoll_event ev;
+	ev.events   = EPOLLIN;
+	ev.data.u32 = 0;
+	if (net_set_nonblocking(listen_fd) != 0 || epfd < 0 ||
+	    epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &ev) != 0 ||
+	    event_watch(epfd, on_spectate_event, NULL) != 0) {
+		close(listen_fd);
+		if (epfd >= 0) close(epfd);
+		listen_fd = epfd = -1;
+		return -1;
+	}
+
+	game_board   = G;
+	game_history = H;
+	game_start   = start;
+	stream_seq   = 0;
+	n_watchers   = 0;
+	for (int i = 0; i < SPECTATE_MAX_WATCHERS; i++)
+		watchers[i].fd = -1;
+	return 0;
+}
+
+void spectate_send(int type, const void* payload, int len) {
+	if (listen_fd < 0)
+		return;
+
+	Chunk* c = chunk_new(type, stream_seq++, payload, len);
+	if (!c)
+		return;
+	for (int i = 0; i < SPECTATE_MAX_WATCHERS && n_watchers > 0; i++) {
+		if (watchers[i].fd >= 0)
+			watcher_push(&watchers[i], c);
+	}
+	chunk_unref(c);
+}
+
+int spectate_count(void) {
+	return n_watchers;
+}
+
+void spectate_close(void) {
+	if (listen_fd < 0)
+		return;
+	for (int i = 0; i < SPECTATE_MAX_WATCHERS; i++) {
+		if (watchers[i].fd >= 0)
+			watcher_flush(&watchers[i]);
+		if (watchers[i].fd >= 0)
+			watcher_drop(&watchers[i]);
+	}
+	event_unwatch(epfd);
+	close(epfd);
+	close(listen_fd);
+	listen_fd = epfd = -1;
+}
@@ -0,0 +1,39 @@
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+#pragma once
+
+#include "gamelogic.h"
+#include "history.h"
+
+/* Spectator channel of a hosted online game.
+ *
+ * Watchers connect to a second port and receive the game as frames
+ * (net.h): first one NET_CATCHUP frame with the whole history, then every
+ * move, undo, redo, chat line and resignation as it happens. Each frame is
+ * encoded once and its buffer shared by the queues of all watchers. Their
+ * sockets are non-blocking and served from the event loop through one
+ * epoll descriptor, so a slow watcher never holds up the game; one that
+ * falls SPECTATE_BACKLOG frames behind is dropped.
+ */
+
+#define SPECTATE_MAX_WATCHERS 256
+#define SPECTATE_BACKLOG      64
+
+/* Listens for watchers on port. G and H are the host's game: G is hashed
+ * into every frame, and both are read when a watcher joins to build its
+ * catch-up frame. 0, or -1 on error. */
+int  spectate_open(int port, const Board* G, const History* H, char start);
+
+/* Sends an action to every watcher, once G shows the board after it. Does
+ * nothing when the channel is not open. */
+void spectate_send(int type, const void* payload, int len);
+
+/* Watchers connected right now. */
+int  spectate_count(void);
+
+/* Sends what the sockets take without waiting, then closes every
+ * watcher and the port. */
+void spectate_close(void);
+
+#endif
@@ -0,0 +1,161 @@
+#include "tt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// On-disk header, padded to one cache line so the buckets stay aligned
+typedef struct {
+	char     magic[4];
+	uint32_t version;
+	uint32_t entry_bytes;
+	uint32_t bucket_entries;
+	uint64_t buckets;
+	uint32_t key_scheme;
+	uint8_t  reserved[36];
+} TTFileHeader;
+
+_Static_assert(sizeof(TTFileHeader) == sizeof(TTBucket), "TT header must be one bucket");
+
+#define TT_TABLE_BYTES (sizeof(TTBucket) * (size_t)TT_BUCKETS)
+#define TT_MAP_BYTES   (sizeof(TTFileHeader) + TT_TABLE_BYTES)
+
+TTBucket* tt_table = NULL;
+unsigned  tt_age   = 0;
+
+static void* tt_map = NULL;   // whole mapping, header included
+
+static void tt_fill_header(TTFileHeader* h) {
+	memset(h, 0, sizeof(*h));
+	memcpy(h->magic, TT_FILE_MAGIC, 4);
+	h->version        = TT_FILE_VERSION;
+	h->entry_bytes    = sizeof(uint64_t);
+	h->bucket_entries = TT_BUCKET_ENTRIES;
+	h->buckets        = TT_BUCKETS;
+	h->key_scheme     = TT_KEY_SCHEME;
+}
+
+static int tt_header_ok(const TTFileHeader* h) {
+	TTFileHeader want;
+	tt_fill_header(&want);
+	return memcmp(h, &want, sizeof(want)) == 0;
+}
+
+// A table we may not write to is still worth reading: map it copy-on-write
+// so this process's stores stay private.
+static void* tt_map_readonly(const char* path) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	void* map = MAP_FAILED;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size == (off_t)TT_MAP_BYTES) {
+		map = mmap(NULL, TT_MAP_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED && !tt_header_ok((TTFileHeader*)map)) {
+			munmap(map, TT_MAP_BYTES);
+			map = MAP_FAILED;
+		}
+	}
+	close(fd);
+	return (map == MAP_FAILED) ? NULL : map;
+}
+
+// Map `path` shared, creating or resetting it when the header doesn't match.
+// The exclusive flock covers the check-and-reset so concurrent processes
+// starting together can't both initialise the file.
+static void* tt_map_file(const char* path) {
+	int fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+		return tt_map_readonly(path);
+
+	flock(fd, LOCK_EX);
+
+	void* map = MAP_FAILED;
+	struct stat st;
+	if (fstat(fd, &st) == 0) {
+		int fresh = (st.st_size != (off_t)TT_MAP_BYTES);
+		if (fresh && (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)TT_MAP_BYTES) != 0))
+			goto out;
+
+		map = mmap(NULL, TT_MAP_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (map == MAP_FAILED)
+			goto out;
+
+		TTFileHeader* h = (TTFileHeader*)map;
+		if (!fresh && !tt_header_ok(h)) {
+			// Stale layout or key scheme: zero the table without touching
+			// every page by truncating the file away and back
+			munmap(map, TT_MAP_BYTES);
+			map = MAP_FAILED;
+			if (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)TT_MAP_BYTES) != 0)
+				goto out;
+			map = mmap(NULL, TT_MAP_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (map == MAP_FAILED)
+				goto out;
+			h = (TTFileHeader*)map;
+		}
+		if (!tt_header_ok(h))
+			tt_fill_header(h);
+	}
+
+out:
+	flock(fd, LOCK_UN);
+	close(fd);   // the mapping keeps the file alive
+	return (map == MAP_FAILED) ? NULL : map;
+}
+
+int tt_open(const char* path) {
+	if (tt_map) return 1;
+
+	void* map = path ? tt_map_file(path) : NULL;
+	int from_file = (map != NULL);
+	if (!map) {
+		// No file (or not writable): fall back to a private zeroed table
+		map = mmap(NULL, TT_MAP_BYTES, PROT_READ | PROT_WRITE,
+		           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (map == MAP_FAILED) {
+			fprintf(stderr, "ERROR: Failed to allocate transposition table\n");
+			exit(1);
+		}
+		tt_fill_header((TTFileHeader*)map);
+	}
+
+	// Probes hit random buckets; readahead would only waste I/O
+	madvise(map, TT_MAP_BYTES, MADV_RANDOM);
+
+	tt_map   = map;
+	tt_table = (TTBucket*)((char*)map + sizeof(TTFileHeader));
+	return from_file;
+}
+
+void tt_init() {
+	tt_open(TT_FILE);
+}
+
+void tt_clear() {
+	if (tt_table) memset(tt_table, 0, TT_TABLE_BYTES);
+}
+
+// Called once per root search so replacement can tell stale entries apart
+unsigned tt_new_search() {
+	return __atomic_add_fetch(&tt_age, 1, __ATOMIC_RELAXED) & 31;
+}
+
+// Start write-back of dirty pages without waiting for it
+void tt_flush() {
+	if (tt_map) msync(tt_map, TT_MAP_BYTES, MS_ASYNC);
+}
+
+void tt_free() {
+	if (!tt_map) return;
+	tt_flush();
+	munmap(tt_map, TT_MAP_BYTES);
+	tt_map   = NULL;
+	tt_table = NULL;
+}
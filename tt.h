@@ -0,0 +1,171 @@
+#ifndef TT_H
+#define TT_H
+
+#pragma once
+
+#include <stdint.h>
+
+/* Shared, lock-free transposition table.
+ *
+ * Each entry is one 64-bit word so it is read and written with a single
+ * atomic access: the low 32 bits hold the data, the high 32 bits hold the
+ * upper key half XOR-ed with the data. A torn or foreign entry fails the
+ * XOR check and is treated as a miss. The lower key bits select the bucket.
+ *
+ * data layout: value:16 | depth:6 | flag:2 | move:3 | age:5
+ *
+ * Buckets are one 64-byte cache line (8 entries); replacement prefers
+ * empty slots, then the shallowest / oldest entry.
+ */
+
+#define TT_BUCKET_ENTRIES 8
+#define TT_BUCKETS        (1 << 20)   /* 8M entries, 64 MB */
+#define TT_NO_MOVE        7
+
+/* Persistent table file. It is a 64-byte header followed by the buckets and
+ * is mapped with mmap(MAP_SHARED): pages load on demand, stores reach the
+ * page cache directly, and several processes on one host can share it.
+ * Bump TT_FILE_VERSION when the entry layout changes and TT_KEY_SCHEME when
+ * the position keys change; a file that doesn't match is reinitialised. */
+#define TT_FILE           "tt.bin"
+#define TT_FILE_MAGIC     "C4TT"
+#define TT_FILE_VERSION   1
+#define TT_KEY_SCHEME     2   /* fixed-seed splitmix64 Zobrist */
+
+typedef enum { EXACT, LOWERBOUND, UPPERBOUND } TTFlag;
+
+typedef struct {
+	uint64_t e[TT_BUCKET_ENTRIES];
+} __attribute__((aligned(64))) TTBucket;
+
+extern TTBucket* tt_table;
+/* Search generation. tt_new_search advances it atomically and returns
+ * the new age (0..31); each search keeps that value for all its stores,
+ * so concurrent searches never read an age another one is changing. */
+extern unsigned  tt_age;
+
+void tt_init();
+int  tt_open(const char* path);   /* NULL = private in-memory table */
+void tt_clear();
+unsigned tt_new_search();
+static inline unsigned tt_current_age(void) {
+	return __atomic_load_n(&tt_age, __ATOMIC_RELAXED) & 31;
+}
+void tt_flush();
+void tt_free();
+
+static inline TTBucket* tt_bucket(uint64_t key) {
+	return &tt_table[key & (TT_BUCKETS - 1)];
+}
+
+static inline void tt_prefetch(uint64_t key) {
+	__builtin_prefetch(tt_bucket(key));
+}
+
+static inline uint32_t tt_pack(int value, int depth, TTFlag flag, int move, unsigned age) {
+	if (depth < 0)  depth = 0;
+	if (depth > 63) depth = 63;
+	if (move < 0 || move >= TT_NO_MOVE) move = TT_NO_MOVE;
+	/* flag is stored +1 so an all-zero word is never a valid entry */
+	return (uint32_t)(uint16_t)(int16_t)value
+	     | (uint32_t)depth << 16
+	     | (uint32_t)(flag + 1) << 22
+	     | (uint32_t)move << 24
+	     | (uint32_t)(age & 31) << 27;
+}
+
+static inline int tt_data_value(uint32_t d) { return (int16_t)(d & 0xFFFF); }
+static inline int tt_data_depth(uint32_t d) { return (d >> 16) & 63; }
+static inline int tt_data_flag(uint32_t d)  { return (int)((d >> 22) & 3) - 1; }
+static inline int tt_data_move(uint32_t d)  { return (d >> 24) & 7; }
+static inline int tt_data_age(uint32_t d)   { return (d >> 27) & 31; }
+
+/* Finds the entry for key; returns 1 and its data word on a hit. */
+static inline int tt_lookup(uint64_t key, uint32_t* out) {
+	TTBucket* b = tt_bucket(key);
+	uint32_t check = (uint32_t)(key >> 32);
+	for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+		uint64_t w = __atomic_load_n(&b->e[i], __ATOMIC_RELAXED);
+		uint32_t d = (uint32_t)w;
+		if (d && ((uint32_t)(w >> 32) ^ d) == check) {
+			*out = d;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* age: the storing search's tt_new_search value */
+static inline void tt_store(uint64_t key, int value, int depth, TTFlag flag, int best_move,
+                            unsigned age) {
+	TTBucket* b = tt_bucket(key);
+	uint32_t check  = (uint32_t)(key >> 32);
+	int      victim = 0;
+	int      worst  = 1 << 30;
+
+	for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+		uint64_t w = __atomic_load_n(&b->e[i], __ATOMIC_RELAXED);
+		uint32_t d = (uint32_t)w;
+		if (!d) {
+			victim = i;
+			break;
+		}
+		if (((uint32_t)(w >> 32) ^ d) == check) {
+			/* Same position: keep a deeper result from this search unless
+			 * the new one is exact */
+			if (tt_data_depth(d) > depth && tt_data_age(d) == (int)(age & 31)
+			    && flag != EXACT)
+				return;
+			victim = i;
+			break;
+		}
+		/* Shallow entries from old searches go first. A gap over 16 is
+		 * an entry from a search that started after this one: current. */
+		int age_gap  = (int)((age - (unsigned)tt_data_age(d)) & 31);
+		if (age_gap > 16)
+			age_gap = 0;
+		int priority = tt_data_depth(d) - 8 * age_gap;
+		if (priority < worst) {
+			worst  = priority;
+			victim = i;
+		}
+	}
+
+	uint32_t d = tt_pack(value, depth, flag, best_move, age);
+	uint64_t w = ((uint64_t)(check ^ d) << 32) | d;
+	__atomic_store_n(&b->e[victim], w, __ATOMIC_RELAXED);
+}
+
+static inline int tt_probe(uint64_t key, int depth, int alpha, int beta,
+                           int* out_value, int* out_move) {
+	uint32_t d;
+	if (!tt_lookup(key, &d)) return 0;
+
+	if (out_move && tt_data_move(d) != TT_NO_MOVE) {
+		*out_move = tt_data_move(d);
+	}
+
+	if (tt_data_depth(d) < depth) {
+		/* Stored result is from a shallower search – still use move hint, but no bound */
+		return 0;
+	}
+
+	int val  = tt_data_value(d);
+	int flag = tt_data_flag(d);
+	if (flag == EXACT) {
+		*out_value = val;
+		return 1;
+	} else if (flag == LOWERBOUND) {
+		if (val > alpha) alpha = val;
+	} else if (flag == UPPERBOUND) {
+		if (val < beta) beta = val;
+	}
+	if (alpha >= beta) {
+		*out_value = val;
+		return 1;
+	}
+
+	return 0;
+}
+
+#endif
@@ -1,73 +1,138 @@
-#define _XOPEN_SOURCE 500 // this enables usleep in c11 because it hides it
 #include "ui.h"
+#include "event.h"
+#include "input.h"
+
+#include <errno.h>
+#include <poll.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
-static void ui_print_header_row(void) {
-	printf("   ");
-	for (int c = 0; c < COLS; c++)
-		printf(" %d", c + 1);
-	puts("\n  +---------------+");
+// Every board frame is composed in ui_frame and sent with one write, so a
+// terminal never shows half a board
+static char               ui_frame[UI_FRAME_BYTES];
+static int                ui_out_fd = STDOUT_FILENO;
+static unsigned long long ui_frames, ui_bytes;
+
+// Screen position of cell (r, c) right after a clear and a full frame:
+// a blank line, the column numbers and the top border come first
+#define UI_CELL_LINE(r) (4 + (r))
+#define UI_CELL_COL(c)  (5 + 2 * (c))
+
+void ui_set_output(int fd) {
+	ui_out_fd = fd;
 }
 
-void ui_clear_screen(void) {
-	fputs("\033[H\033[J", stdout);
+void ui_frame_stats(unsigned long long* frames, unsigned long long* bytes) {
+	*frames = ui_frames;
+	*bytes  = ui_bytes;
 }
 
-void ui_print_board(const Board* g, int use_color) {
-	puts("");
-	ui_print_header_row();
+static char* put_str(char* p, const char* s) {
+	size_t n = strlen(s);
+	memcpy(p, s, n);
+	return p + n;
+}
+
+static char* put_cell(char* p, char ch, int use_color) {
+	if (use_color && ch == 'A')
+		return put_str(p, "\033[33mA\033[0m");
+	if (use_color && ch == 'B')
+		return put_str(p, "\033[31mB\033[0m");
+	*p = ch;
+	return p + 1;
+}
+
+// Absolute cursor move, 1-based
+static char* put_goto(char* p, int line, int col) {
+	return p + sprintf(p, "\033[%d;%dH", line, col);
+}
+
+// Sends ui_frame[0..len) after anything still buffered in stdout
+static void ui_emit(size_t len) {
+	fflush(stdout);
+	const char* p = ui_frame;
+	while (len > 0) {
+		ssize_t n = write(ui_out_fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && errno == EAGAIN) {
+			struct pollfd pfd = { .fd = ui_out_fd, .events = POLLOUT };
+			poll(&pfd, 1, -1);
+			continue;
+		}
+		if (n <= 0)
+			return;
+		p         += n;
+		len       -= (size_t)n;
+		ui_bytes  += (unsigned long long)n;
+	}
+	ui_frames++;
+}
+
+static char* put_board(char* p, const Board* g, int use_color) {
+	p = put_str(p, "\n    ");
+	for (int c = 0; c < COLS; c++) {
+		*p++ = (char)('1' + c);
+		*p++ = ' ';
+	}
+	p[-1] = '\n';
+	p = put_str(p, "  +---------------+\n");
 	for (int r = 0; r < ROWS; r++) {
-		printf("%d | ", ROWS - r);
+		*p++ = (char)('0' + ROWS - r);
+		p = put_str(p, " | ");
 		for (int c = 0; c < COLS; c++) {
-			char ch = getChar(g, r, c);
-			if (use_color == 0) {
-				printf("%c ", ch);
-			} else {
-				if (ch == 'A')
-					fputs("\033[33mA\033[0m ", stdout);
-				else if (ch == 'B')
-					fputs("\033[31mB\033[0m ", stdout);
-				else
-					printf("%c ", ch);
-			}
+			p = put_cell(p, getChar(g, r, c), use_color);
+			*p++ = ' ';
 		}
-		puts("|");
+		p = put_str(p, "|\n");
 	}
-	puts("  +---------------+");
+	return put_str(p, "  +---------------+\n");
 }
 
+void ui_clear_screen(void) {
+	fputs("\033[H\033[J", stdout);
+}
+
+void ui_print_board(const Board* g, int use_color) {
+	ui_emit((size_t)(put_board(ui_frame, g, use_color) - ui_frame));
+}
+
+// The first frame clears the screen and draws the board with the piece in
+// the top row. Each later frame only moves the piece down a row: it blanks
+// the cell above and draws the piece, between saving and restoring the
+// cursor so text printed meanwhile stays where it is.
 int ui_drop_with_animation(Board* g, int col, char player, const UiOptions* opt) {
 	int landing = game_can_drop(g, col);
 	if (landing == -1)
 		return -1;
-	Board temp = *g;
+
+	int use_color = opt ? opt->use_color : 0;
+	int ms        = opt ? opt->delay_ms : 100;
+	if (ms < 0)
+		ms = 0;
+
 	for (int r = 0; r <= landing; r++) {
-		temp = *g;
-		if (getChar(&temp, r, col) != EMPTY)
-			continue;
-		setChar(&temp, r, col, player);
-		ui_clear_screen();
-		int use_color = 0;
-		if (opt)
-			use_color = opt->use_color;
-		ui_print_board(&temp, use_color);
-		fflush(stdout);
-		int ms;
-		if (opt)
-			ms = opt->delay_ms;
-		else
-			ms = 100;
-		if (ms < 0)
-			ms = 0;
-		usleep((unsigned)(ms) * 1000);
+		char* p = ui_frame;
+		if (r == 0) {
+			Board temp = *g;
+			setChar(&temp, 0, col, player);
+			p = put_str(p, "\033[H\033[J");
+			p = put_board(p, &temp, use_color);
+		} else {
+			p = put_str(p, "\0337");
+			p = put_goto(p, UI_CELL_LINE(r - 1), UI_CELL_COL(col));
+			p = put_cell(p, EMPTY, use_color);
+			p = put_goto(p, UI_CELL_LINE(r), UI_CELL_COL(col));
+			p = put_cell(p, player, use_color);
+			p = put_str(p, "\0338");
+		}
+		ui_emit((size_t)(p - ui_frame));
+		// Frames are timers on the event loop: input and chat keep flowing
+		event_sleep(ms);
 	}
+	// The last frame already shows the piece where it landed
 	setChar(g, landing, col, player);
-	ui_clear_screen();
-	int use_color_final = 0;
-	if (opt)
-		use_color_final = opt->use_color;
-	ui_print_board(g, use_color_final);
 	return landing;
 }
 
@@ -75,7 +140,7 @@ void ui_wait_for_enter(void) {
 	char buf[16];
 	printf("\nPress Enter to continue...");
 	fflush(stdout);
-	if(!fgets(buf, sizeof buf, stdin)){}
+	if(!read_line(buf, sizeof buf)){}
 }
 
 int ui_main_menu(void) {
@@ -91,7 +156,7 @@ int ui_main_menu(void) {
 		fflush(stdout);
 
 		char line[16];
-		if (!fgets(line, sizeof line, stdin)) {
+		if (!read_line(line, sizeof line)) {
 			return 0;
 		}
 
@@ -119,7 +184,7 @@ int ui_bot_menu(void) {
 		fflush(stdout);
 
 		char line[16];
-		if (!fgets(line, sizeof line, stdin)) {
+		if (!read_line(line, sizeof line)) {
 			return 0;
 		}
 
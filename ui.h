@@ -4,14 +4,25 @@
 #pragma once
 #include "gamelogic.h"
 
+/* Largest frame: a colored board, or the clear and board of an animation */
+#define UI_FRAME_BYTES 1024
+
 typedef struct {
 	int use_color;
 	int delay_ms;
 } UiOptions;
 
 void ui_clear_screen(void);
+/* Composes the whole board in one buffer and sends it with a single write,
+ * after flushing stdout. */
 void ui_print_board(const Board* g, int use_color);
+/* Clears the screen and draws the board once, then each step of the fall
+ * rewrites just the two cells that changed, addressed by cursor position. */
 int ui_drop_with_animation(Board* g, int col, char player, const UiOptions* opt);
+/* Where frames are written (default 1, stdout), and frames and bytes
+ * written so far; connect4-bench --render uses both. */
+void ui_set_output(int fd);
+void ui_frame_stats(unsigned long long* frames, unsigned long long* bytes);
 int ui_main_menu(void);
 int ui_bot_menu(void);
 void ui_show_about(void);